@@ -0,0 +1,4 @@
+#include "bench/benchmarks.hpp"
+
+// the benchmarks for a computer, built by `make host-bench`
+int main() { gamepad::bench::run_all(); }
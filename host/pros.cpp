@@ -0,0 +1,245 @@
+#include "sim.hpp"
+#include "pros/apix.h"
+#include "pros/misc.hpp"
+#include "pros/rtos.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace {
+struct SimTask {
+        /// The task's notification value, guarded by World::mutex
+        uint32_t notifications = 0;
+};
+
+struct VirtualController {
+        uint16_t buttons = 0;
+        int32_t axes[4] {};
+        bool connected = true;
+        int32_t capacity = 100;
+        int32_t level = 100;
+};
+
+/**
+ * @brief Everything that is simulated, which is only ever touched with the mutex held
+ */
+struct World {
+        std::mutex mutex;
+        /// Notified whenever the clock moves or a task is notified
+        std::condition_variable changed;
+        /// The virtual clock, in us
+        uint64_t now = 0;
+        VirtualController controllers[2];
+        int32_t send_result = 1;
+        std::vector<gamepad::sim::Sent> sent;
+        /// The task that main() runs in
+        SimTask main_task;
+};
+
+World& world() {
+    // never destroyed, since detached tasks may still be waiting on it while the program exits
+    static World* world = new World;
+    return *world;
+}
+
+thread_local SimTask* current_task = nullptr;
+
+SimTask* current() { return current_task != nullptr ? current_task : &world().main_task; }
+
+VirtualController& controller(pros::controller_id_e_t id) {
+    return world().controllers[id == pros::E_CONTROLLER_PARTNER];
+}
+
+/**
+ * @brief Waits until the clock reaches a time, the program drives the clock so only other tasks wait for it
+ *
+ * @param until The time to wait for, in us
+ */
+void wait_until(uint64_t until) {
+    std::unique_lock lock(world().mutex);
+    if (current_task == nullptr) {
+        // the program itself is waiting, so nothing else would move the clock
+        if (world().now < until) world().now = until;
+        world().changed.notify_all();
+        return;
+    }
+    world().changed.wait(lock, [&] { return world().now >= until; });
+}
+} // namespace
+
+namespace gamepad::sim {
+void reset() {
+    std::lock_guard lock(world().mutex);
+    world().now = 0;
+    for (auto& controller : world().controllers) controller = {};
+    world().send_result = 1;
+    world().sent.clear();
+    world().changed.notify_all();
+}
+
+uint32_t time() {
+    std::lock_guard lock(world().mutex);
+    return world().now / 1000;
+}
+
+void advance(uint32_t ms) {
+    std::lock_guard lock(world().mutex);
+    world().now += ms * uint64_t(1000);
+    world().changed.notify_all();
+}
+
+void set_button(pros::controller_id_e_t id, pros::controller_digital_e_t button, bool held) {
+    std::lock_guard lock(world().mutex);
+    const uint16_t bit = 1 << (button - pros::E_CONTROLLER_DIGITAL_L1);
+    if (held) controller(id).buttons |= bit;
+    else controller(id).buttons &= ~bit;
+}
+
+void set_axis(pros::controller_id_e_t id, pros::controller_analog_e_t axis, int32_t value) {
+    std::lock_guard lock(world().mutex);
+    controller(id).axes[axis] = value;
+}
+
+void set_connected(pros::controller_id_e_t id, bool connected) {
+    std::lock_guard lock(world().mutex);
+    controller(id).connected = connected;
+}
+
+void set_battery(pros::controller_id_e_t id, int32_t capacity, int32_t level) {
+    std::lock_guard lock(world().mutex);
+    controller(id).capacity = capacity;
+    controller(id).level = level;
+}
+
+void set_send_result(int32_t result) {
+    std::lock_guard lock(world().mutex);
+    world().send_result = result;
+}
+
+std::vector<Sent> sent() {
+    std::lock_guard lock(world().mutex);
+    return world().sent;
+}
+
+void clear_sent() {
+    std::lock_guard lock(world().mutex);
+    world().sent.clear();
+}
+} // namespace gamepad::sim
+
+namespace pros::c {
+uint32_t millis() { return gamepad::sim::time(); }
+
+uint64_t micros() {
+    std::lock_guard lock(world().mutex);
+    return world().now;
+}
+
+void delay(const uint32_t milliseconds) { wait_until(micros() + milliseconds * uint64_t(1000)); }
+
+void task_delay(const uint32_t milliseconds) { delay(milliseconds); }
+
+void task_delay_until(uint32_t* const prev_time, const uint32_t delta) {
+    *prev_time += delta;
+    wait_until(*prev_time * uint64_t(1000));
+}
+
+task_t task_create(task_fn_t function, void* const parameters, uint32_t, const uint16_t, const char*) {
+    SimTask* task = new SimTask;
+    std::thread([=] {
+        current_task = task;
+        function(parameters);
+    }).detach();
+    return task;
+}
+
+task_t task_get_current() { return current(); }
+
+uint32_t task_notify(task_t task) {
+    std::lock_guard lock(world().mutex);
+    static_cast<SimTask*>(task)->notifications++;
+    world().changed.notify_all();
+    return 1;
+}
+
+uint32_t task_notify_take(bool clear_on_exit, uint32_t timeout) {
+    SimTask* task = current();
+    std::unique_lock lock(world().mutex);
+    const uint64_t until = world().now + timeout * uint64_t(1000);
+    world().changed.wait(lock, [&] {
+        return task->notifications > 0 || (timeout != TIMEOUT_MAX && world().now >= until);
+    });
+    const uint32_t value = task->notifications;
+    if (clear_on_exit) task->notifications = 0;
+    else if (value > 0) task->notifications--;
+    return value;
+}
+
+bool task_notify_clear(task_t task) {
+    std::lock_guard lock(world().mutex);
+    const bool was_pending = static_cast<SimTask*>(task)->notifications > 0;
+    static_cast<SimTask*>(task)->notifications = 0;
+    return was_pending;
+}
+
+mutex_t mutex_recursive_create() { return new std::recursive_timed_mutex; }
+
+bool mutex_recursive_take(mutex_t mutex, uint32_t timeout) {
+    auto* recursive = static_cast<std::recursive_timed_mutex*>(mutex);
+    if (timeout == TIMEOUT_MAX) {
+        recursive->lock();
+        return true;
+    }
+    return recursive->try_lock_for(std::chrono::milliseconds(timeout));
+}
+
+bool mutex_recursive_give(mutex_t mutex) {
+    static_cast<std::recursive_timed_mutex*>(mutex)->unlock();
+    return true;
+}
+
+void mutex_delete(mutex_t mutex) { delete static_cast<std::recursive_timed_mutex*>(mutex); }
+
+int32_t controller_set_text(controller_id_e_t id, uint8_t line, uint8_t col, const char* str) {
+    std::lock_guard lock(world().mutex);
+    world().sent.push_back({static_cast<uint32_t>(world().now / 1000), id, false, line, col, str});
+    return world().send_result;
+}
+
+int32_t controller_rumble(controller_id_e_t id, const char* rumble_pattern) {
+    std::lock_guard lock(world().mutex);
+    world().sent.push_back({static_cast<uint32_t>(world().now / 1000), id, true, 0, 0, rumble_pattern});
+    return world().send_result;
+}
+} // namespace pros::c
+
+namespace pros {
+Controller::Controller(controller_id_e_t id)
+    : _id(id) {}
+
+int32_t Controller::is_connected() {
+    std::lock_guard lock(world().mutex);
+    return controller(this->_id).connected;
+}
+
+int32_t Controller::get_digital(controller_digital_e_t button) {
+    std::lock_guard lock(world().mutex);
+    return controller(this->_id).buttons >> (button - E_CONTROLLER_DIGITAL_L1) & 1;
+}
+
+int32_t Controller::get_analog(controller_analog_e_t channel) {
+    std::lock_guard lock(world().mutex);
+    return controller(this->_id).axes[channel];
+}
+
+int32_t Controller::get_battery_capacity() {
+    std::lock_guard lock(world().mutex);
+    return controller(this->_id).capacity;
+}
+
+int32_t Controller::get_battery_level() {
+    std::lock_guard lock(world().mutex);
+    return controller(this->_id).level;
+}
+} // namespace pros
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pros/misc.h"
+
+/**
+ * @brief A stand-in for the parts of PROS that the library uses, so it can run on a computer instead of the brain
+ *
+ * `make host` builds the library together with host/pros.cpp into bin/host/libgamepad.a, which is linked into a
+ * program for the computer (with -pthread), such as a unit test, fuzzer or benchmark. Nothing here is part of the
+ * library that is sent to the brain.
+ *
+ * The controllers are virtual, and are set up by the program instead of being held by a driver. The clock is virtual
+ * too, and only moves when the program advances it, or when main() itself calls pros::delay(), so a test runs as fast
+ * as the computer allows, and runs the same every time. Tasks are threads, and a task waiting on the clock
+ * (pros::delay(), pros::c::task_delay_until() or a notification with a timeout) wakes once the program has advanced the
+ * clock far enough, so tasks never move the clock themselves. Mutex timeouts are in real time, since nothing would
+ * advance the clock while the program is waiting on one.
+ *
+ * `make host-test` builds and runs the tests in host/test, which are written against this backend.
+ *
+ * @b Example:
+ * @code {.cpp}
+ *   #include "gamepad/api.hpp"
+ *   #include "sim.hpp"
+ *
+ *   int main() {
+ *       int presses = 0;
+ *       gamepad::master.A.onPress("count", [&]() { ++presses; });
+ *       gamepad::sim::set_button(pros::E_CONTROLLER_MASTER, pros::E_CONTROLLER_DIGITAL_A, true);
+ *       gamepad::sim::advance(10);
+ *       gamepad::master.update();
+ *       return presses == 1 ? 0 : 1;
+ *   }
+ * @endcode
+ */
+namespace gamepad::sim {
+/**
+ * @brief Something the library sent to a controller
+ */
+struct Sent {
+        /// When it was sent, in ms
+        uint32_t time;
+        pros::controller_id_e_t controller;
+        /// Whether this is a rumble pattern, instead of text for the screen
+        bool rumble;
+        /// Where the text was written, both are 0 for a rumble pattern
+        uint8_t line, column;
+        /// The text, or the rumble pattern
+        std::string text;
+};
+
+/**
+ * @brief Put everything back how it started: the clock at 0, both controllers connected with nothing held and a full
+ * battery, sends succeeding, and nothing sent yet
+ */
+void reset();
+/**
+ * @brief Get the time on the virtual clock
+ *
+ * @return uint32_t The time in ms, the same as pros::millis()
+ */
+uint32_t time();
+/**
+ * @brief Move the virtual clock forward, waking any task that was waiting for it
+ *
+ * @param ms How far to move the clock, in ms
+ */
+void advance(uint32_t ms);
+/**
+ * @brief Hold or release a button on a virtual controller
+ *
+ * @param controller Which controller
+ * @param button Which button
+ * @param held Whether or not the button is held
+ */
+void set_button(pros::controller_id_e_t controller, pros::controller_digital_e_t button, bool held);
+/**
+ * @brief Move a joystick on a virtual controller
+ *
+ * @param controller Which controller
+ * @param axis Which joystick axis
+ * @param value The value of the axis, from -127 to 127
+ */
+void set_axis(pros::controller_id_e_t controller, pros::controller_analog_e_t axis, int32_t value);
+/**
+ * @brief Connect or disconnect a virtual controller
+ *
+ * @param controller Which controller
+ * @param connected Whether or not the controller is connected
+ */
+void set_connected(pros::controller_id_e_t controller, bool connected);
+/**
+ * @brief Set the battery of a virtual controller
+ *
+ * @param controller Which controller
+ * @param capacity The battery capacity, in percent
+ * @param level The battery level
+ */
+void set_battery(pros::controller_id_e_t controller, int32_t capacity, int32_t level);
+/**
+ * @brief Set what sending text or a rumble pattern to a controller returns, such as PROS_ERR to simulate a busy link
+ *
+ * @param result The return value, 1 by default
+ */
+void set_send_result(int32_t result);
+/**
+ * @brief Get everything sent to the controllers since the last clear_sent() or reset(), oldest first
+ */
+std::vector<Sent> sent();
+/**
+ * @brief Forget everything sent to the controllers so far
+ */
+void clear_sent();
+} // namespace gamepad::sim
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdio>
+
+namespace gamepad::test {
+/// How many checks have failed so far
+inline int failures = 0;
+} // namespace gamepad::test
+
+/**
+ * @brief Reports a failed check without stopping the test, main() returns gamepad::test::failures != 0
+ */
+#define CHECK(condition)                                                                                               \
+    do {                                                                                                               \
+        if (!(condition)) {                                                                                            \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);                                  \
+            ++gamepad::test::failures;                                                                                 \
+        }                                                                                                              \
+    } while (0)
@@ -0,0 +1,109 @@
+#include "check.hpp"
+#include "gamepad/event_handler.hpp"
+#include "gamepad/recursive_mutex.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+template <typename Lock> using Handler = gamepad::_impl::BasicEventHandler<Lock, std::string>;
+
+/**
+ * @brief Listeners that add and remove listeners of the event they are running in, including themselves
+ */
+template <typename Lock> void mutate_inside_callbacks() {
+    Handler<Lock> handler;
+    int first = 0, second = 0, added = 0;
+    handler.add_listener("first", [&]() {
+        ++first;
+        // the new listener must wait for the next fire, and the removed one must not run for the rest of this one
+        handler.add_listener("added", [&]() { ++added; });
+        handler.remove_listener("second");
+    });
+    handler.add_listener("second", [&]() { ++second; });
+    handler.fire();
+    CHECK(first == 1);
+    CHECK(second == 0);
+    CHECK(added == 0);
+    handler.fire();
+    CHECK(first == 2);
+    CHECK(added == 1);
+
+    // a listener that removes itself, then adds itself back under the same key, from inside a nested fire
+    Handler<Lock> nested;
+    int outer = 0, inner = 0;
+    nested.add_listener("outer", [&]() {
+        if (++outer > 1) return;
+        nested.fire();
+    });
+    nested.add_listener("self", [&]() {
+        ++inner;
+        nested.remove_listener("self");
+        CHECK(nested.add_listener("self", [&]() { ++inner; }));
+    });
+    nested.fire();
+    CHECK(outer == 2);
+    CHECK(inner == 1);
+    nested.fire();
+    CHECK(inner == 2);
+    CHECK(nested.remove_listener("outer"));
+    CHECK(nested.remove_listener("self"));
+    CHECK(nested.is_empty());
+}
+
+/**
+ * @brief Fires an event over and over while other threads add and remove listeners, and listeners add and remove
+ * listeners too
+ */
+void mutate_from_other_threads() {
+    constexpr int THREADS = 4;
+    constexpr int ROUNDS = 2000;
+    Handler<gamepad::_impl::RecursiveMutex> handler;
+    std::atomic<uint32_t> fires = 0;
+    std::atomic<int> running = THREADS;
+    std::atomic<bool> failed = false;
+
+    handler.add_listener("churn", [&]() {
+        fires.fetch_add(1, std::memory_order_relaxed);
+        handler.remove_listener("churned");
+        handler.add_listener("churned", [&]() { fires.fetch_add(1, std::memory_order_relaxed); });
+    });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            const std::string key = "thread" + std::to_string(t);
+            for (int i = 0; i < ROUNDS; ++i) {
+                if (!handler.add_listener(key, [&]() { fires.fetch_add(1, std::memory_order_relaxed); })) {
+                    failed = true;
+                }
+                if (!handler.remove_listener(key)) failed = true;
+            }
+            running.fetch_sub(1);
+        });
+    }
+    // fire at least once, even if every thread is done before this one gets going
+    uint32_t fired = 0;
+    do {
+        handler.fire();
+        ++fired;
+    } while (running.load() > 0);
+    for (auto& thread : threads) thread.join();
+
+    CHECK(!failed);
+    // churn runs on every fire, so at least that many listeners ran
+    CHECK(fires.load() >= fired);
+    CHECK(handler.remove_listener("churn"));
+    CHECK(handler.remove_listener("churned"));
+    CHECK(handler.is_empty());
+}
+} // namespace
+
+int main() {
+    mutate_inside_callbacks<gamepad::_impl::NoLock>();
+    mutate_inside_callbacks<gamepad::_impl::SpinLock>();
+    mutate_inside_callbacks<gamepad::_impl::RecursiveMutex>();
+    mutate_from_other_threads();
+    return gamepad::test::failures != 0;
+}
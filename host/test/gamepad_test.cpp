@@ -0,0 +1,190 @@
+#include "check.hpp"
+#include "gamepad/api.hpp"
+#include "pros/error.h"
+#include "pros/rtos.hpp"
+#include "sim.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using gamepad::master;
+
+namespace {
+constexpr auto MASTER = pros::E_CONTROLLER_MASTER;
+constexpr auto A = pros::E_CONTROLLER_DIGITAL_A;
+
+/// Moves the clock forward, then updates the master controller
+void step(uint32_t ms = 10) {
+    gamepad::sim::advance(ms);
+    master.update();
+}
+
+void press_and_release() {
+    int presses = 0, long_presses = 0, short_releases = 0;
+    master.A.onPress("press", [&]() { ++presses; });
+    master.A.onLongPress("long", [&]() { ++long_presses; });
+    master.A.onShortRelease("short", [&]() { ++short_releases; });
+
+    gamepad::sim::set_button(MASTER, A, true);
+    step();
+    CHECK(presses == 1);
+    CHECK(master.A);
+    gamepad::sim::set_button(MASTER, A, false);
+    step();
+    CHECK(short_releases == 1);
+    CHECK(!master.A);
+
+    gamepad::sim::set_button(MASTER, A, true);
+    for (int i = 0; i < 60; ++i) step();
+    CHECK(presses == 2);
+    CHECK(long_presses == 1);
+    gamepad::sim::set_button(MASTER, A, false);
+    step();
+    CHECK(short_releases == 1);
+
+    master.A.removeListener("press");
+    master.A.removeListener("long");
+    master.A.removeListener("short");
+}
+
+/// The repeat_iterations of each repeat press the binding table ran with
+std::vector<uint32_t> bound_repeats;
+
+void record_repeat(const gamepad::ButtonEvent& event) { bound_repeats.push_back(event.repeat_iterations); }
+
+using RepeatTable = gamepad::BindingTable<gamepad::Binding<A, gamepad::ON_REPEAT_PRESS, record_repeat>>;
+
+void bindings_skip_consumed_repeats() {
+    std::vector<uint32_t> seen;
+    master.A.set_catch_up_policy(gamepad::CATCH_UP_FIRE_ALL);
+    master.A.onRepeatPress("consume second", [&](const gamepad::ButtonEvent& event) {
+        seen.push_back(event.repeat_iterations);
+        if (event.repeat_iterations == 2) event.consume();
+    });
+
+    gamepad::sim::set_button(MASTER, A, true);
+    step();
+    // a late update makes several repeat presses due at once
+    gamepad::sim::advance(700);
+    master.update<RepeatTable>();
+    CHECK(seen.size() >= 3);
+    std::vector<uint32_t> expected;
+    for (uint32_t iteration : seen) {
+        if (iteration != 2) expected.push_back(iteration);
+    }
+    CHECK(bound_repeats == expected);
+    gamepad::sim::set_button(MASTER, A, false);
+    step();
+
+    master.A.removeListener("consume second");
+    master.A.set_catch_up_policy(gamepad::CATCH_UP_DROP);
+}
+
+void axis_thresholds() {
+    constexpr float centered[4] {}, pushed[4] {0, 0, 0, 1}, pulled[4] {0, 0, 0, -1};
+    static_assert(!gamepad::Input::axis(pros::E_CONTROLLER_ANALOG_RIGHT_Y, 0).is_active(0, centered));
+    static_assert(gamepad::Input::axis(pros::E_CONTROLLER_ANALOG_RIGHT_Y, 0).is_active(0, pushed));
+    static_assert(!gamepad::Input::axis(pros::E_CONTROLLER_ANALOG_RIGHT_Y, 0).is_active(0, pulled));
+    static_assert(gamepad::Input::axis(pros::E_CONTROLLER_ANALOG_RIGHT_Y, -1).is_active(0, pulled));
+    static_assert(!gamepad::Input::axis(pros::E_CONTROLLER_ANALOG_RIGHT_Y, 1).is_active(0, centered));
+}
+
+gamepad::Macro press_then_sleep(int& stage) {
+    co_await master.A.pressed();
+    stage = 1;
+    co_await gamepad::sleep_for(50);
+    stage = 2;
+}
+
+void macros_resume_on_their_gamepad() {
+    int stage = 0;
+    press_then_sleep(stage);
+    gamepad::sim::set_button(MASTER, A, true);
+    gamepad::sim::advance(10);
+    gamepad::partner.update();
+    CHECK(stage == 0);
+    master.update();
+    CHECK(stage == 1);
+    // the macro sleeps on the gamepad it waited on, so the partner's update must not resume it
+    gamepad::sim::advance(60);
+    gamepad::partner.update();
+    CHECK(stage == 1);
+    master.update();
+    CHECK(stage == 2);
+    gamepad::sim::set_button(MASTER, A, false);
+    step();
+}
+
+void disconnect_zero() {
+    int presses = 0, releases = 0;
+    master.A.onPress("press", [&]() { ++presses; });
+    master.A.onRelease("release", [&]() { ++releases; });
+
+    gamepad::sim::set_button(MASTER, A, true);
+    step();
+    gamepad::sim::set_connected(MASTER, false);
+    step();
+    CHECK(!master.is_connected());
+    CHECK(!master.A);
+    CHECK(releases == 0);
+
+    // A is still held when the controller comes back, which must not count as a new press
+    gamepad::sim::set_connected(MASTER, true);
+    step();
+    CHECK(master.is_connected());
+    CHECK(!master.A);
+    CHECK(presses == 1);
+    gamepad::sim::set_button(MASTER, A, false);
+    step();
+    gamepad::sim::set_button(MASTER, A, true);
+    step();
+    CHECK(presses == 2);
+    gamepad::sim::set_button(MASTER, A, false);
+    step();
+
+    master.A.removeListener("press");
+    master.A.removeListener("release");
+}
+
+void screen_retries_failed_sends() {
+    gamepad::sim::clear_sent();
+    master.screen.print(0, 0, "hi");
+    gamepad::sim::set_send_result(PROS_ERR);
+    step(50);
+    CHECK(gamepad::sim::sent().size() == 1);
+    CHECK(!master.screen.is_synced());
+    gamepad::sim::set_send_result(1);
+    step(50);
+    CHECK(gamepad::sim::sent().size() == 2);
+    CHECK(master.screen.is_synced());
+    step(50);
+    CHECK(gamepad::sim::sent().size() == 2);
+}
+
+void tasks_wait_for_the_clock() {
+    std::atomic<bool> woke = false;
+    const uint32_t start = gamepad::sim::time();
+    pros::Task::create([&]() {
+        pros::delay(100);
+        woke = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(!woke);
+    CHECK(gamepad::sim::time() == start);
+    gamepad::sim::advance(100);
+    for (int i = 0; i < 100 && !woke; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK(woke);
+}
+} // namespace
+
+int main() {
+    press_and_release();
+    bindings_skip_consumed_repeats();
+    axis_thresholds();
+    macros_resume_on_their_gamepad();
+    disconnect_zero();
+    screen_retries_failed_sends();
+    tasks_wait_for_the_clock();
+    return gamepad::test::failures != 0;
+}
@@ -0,0 +1,231 @@
+#include "check.hpp"
+#include "gamepad/api.hpp"
+#include "gamepad/recording.hpp"
+#include "sim.hpp"
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+using gamepad::InputFrame;
+using gamepad::_impl::FrameDecoder;
+using gamepad::_impl::FrameEncoder;
+
+constexpr uint32_t START = 123456;
+
+/**
+ * @brief Frames that need every kind of record: runs longer than one repeat record holds, intervals that take
+ * multi-byte varints, and changes to the buttons and to each joystick
+ */
+std::vector<InputFrame> sample_frames() {
+    std::vector<InputFrame> frames;
+    InputFrame frame {.timestamp = START};
+    auto add = [&](uint32_t interval, int count) {
+        for (int i = 0; i < count; ++i) {
+            frame.timestamp += interval;
+            frames.push_back(frame);
+        }
+    };
+    add(10, 300);
+    frame.buttons = 0x0801;
+    add(10, 1);
+    frame.axes[2] = -127;
+    add(10, 129);
+    // 200 ms takes a 2 byte varint, and 2^28 ms takes all 5 bytes
+    add(200, 3);
+    frame.axes[0] = 64;
+    add(uint32_t(1) << 28, 2);
+    frame.buttons = 0;
+    frame.axes[0] = 0;
+    frame.axes[3] = 127;
+    add(10, 128);
+    add(0, 5);
+    return frames;
+}
+
+std::vector<uint8_t> encode(const std::vector<InputFrame>& frames) {
+    FrameEncoder encoder;
+    std::vector<uint8_t> bytes(FrameEncoder::HEADER_SIZE);
+    bytes.resize(encoder.begin(START, bytes.data()));
+    uint8_t record[FrameEncoder::MAX_ENCODED_SIZE];
+    for (const auto& frame : frames) {
+        const size_t size = encoder.encode(frame, record);
+        bytes.insert(bytes.end(), record, record + size);
+    }
+    bytes.insert(bytes.end(), record, record + encoder.finish(record));
+    return bytes;
+}
+
+FrameDecoder::Source from(FILE* file) {
+    return [file](uint8_t* out, size_t max) { return std::fread(out, 1, max, file); };
+}
+
+FILE* to_file(const std::vector<uint8_t>& bytes) {
+    FILE* file = std::tmpfile();
+    std::fwrite(bytes.data(), 1, bytes.size(), file);
+    std::rewind(file);
+    return file;
+}
+
+void round_trip() {
+    const auto frames = sample_frames();
+    const auto bytes = encode(frames);
+    // each run of untouched frames costs a byte per 128 frames, instead of a record per frame
+    CHECK(bytes.size() < 64);
+
+    FILE* file = to_file(bytes);
+    FrameDecoder decoder;
+    CHECK(decoder.begin(from(file)));
+    InputFrame frame;
+    for (const auto& expected : frames) {
+        CHECK(decoder.next(frame));
+        CHECK(frame == expected);
+    }
+    CHECK(!decoder.next(frame));
+    std::fclose(file);
+}
+
+void truncated() {
+    const auto frames = sample_frames();
+    const auto bytes = encode(frames);
+    for (size_t size = 0; size < bytes.size(); ++size) {
+        FILE* file = to_file({bytes.begin(), bytes.begin() + size});
+        FrameDecoder decoder;
+        if (size < FrameEncoder::HEADER_SIZE) {
+            CHECK(!decoder.begin(from(file)));
+            std::fclose(file);
+            continue;
+        }
+        CHECK(decoder.begin(from(file)));
+        // a cut off recording plays the frames before the cut, and nothing made up
+        InputFrame frame;
+        size_t read = 0;
+        while (decoder.next(frame)) {
+            CHECK(read < frames.size() && frame == frames[read]);
+            ++read;
+        }
+        CHECK(read < frames.size());
+        std::fclose(file);
+    }
+}
+
+void leading_repeat() {
+    FrameEncoder encoder;
+    std::vector<uint8_t> bytes(FrameEncoder::HEADER_SIZE);
+    encoder.begin(START, bytes.data());
+    bytes.push_back(0x85);
+    FILE* file = to_file(bytes);
+    FrameDecoder decoder;
+    CHECK(decoder.begin(from(file)));
+    InputFrame frame;
+    CHECK(!decoder.next(frame));
+    std::fclose(file);
+}
+
+void replay_disconnects_at_the_end() {
+    const auto frames = sample_frames();
+    const auto bytes = encode(frames);
+    const char* path = "gamepad_recording_test.gpr";
+    FILE* file = std::fopen(path, "wb");
+    std::fwrite(bytes.data(), 1, bytes.size(), file);
+    std::fclose(file);
+
+    gamepad::Replay replay;
+    CHECK(replay.open(path));
+    // the first frame plays at the time it is read, whenever the rest are read
+    InputFrame frame;
+    for (auto expected : frames) {
+        CHECK(replay.read(1000, frame));
+        expected.timestamp += 1000 - frames.front().timestamp;
+        CHECK(frame == expected);
+    }
+    CHECK(!replay.is_finished());
+    CHECK(!replay.read(0, frame));
+    CHECK(replay.is_finished());
+    CHECK(!replay.read(0, frame));
+    replay.close();
+    std::remove(path);
+}
+
+/// Something a listener saw, and when, relative to the first press
+struct Seen {
+        gamepad::EventType type;
+        uint32_t time;
+        uint32_t repeat_iterations;
+
+        bool operator==(const Seen&) const = default;
+};
+
+/**
+ * @brief Plays a session to the master controller, recording the events it fires
+ *
+ * @param update Advances the clock and updates the gamepad, once for each frame
+ */
+template <typename F> std::vector<Seen> session(F&& update) {
+    std::vector<Seen> seen;
+    uint32_t start = 0;
+    auto log = [&](const gamepad::ButtonEvent& event) {
+        if (seen.empty()) start = event.timestamp;
+        seen.push_back({event.type, event.timestamp - start, event.repeat_iterations});
+    };
+    gamepad::master.A.onPress("log press", log);
+    gamepad::master.A.onLongPress("log long press", log);
+    gamepad::master.A.onRepeatPress("log repeat press", log);
+    gamepad::master.A.onLongRelease("log long release", log);
+    gamepad::master.B.onPress("log press", log);
+    gamepad::master.B.onShortRelease("log short release", log);
+    update();
+    for (const char* name : {"log press", "log long press", "log repeat press", "log long release"}) {
+        gamepad::master.A.removeListener(name);
+    }
+    gamepad::master.B.removeListener("log press");
+    gamepad::master.B.removeListener("log short release");
+    return seen;
+}
+
+void replay_fires_the_recorded_events() {
+    constexpr auto MASTER = pros::E_CONTROLLER_MASTER;
+    const char* path = "gamepad_replay_test.gpr";
+    // hold A long enough for a long press and several repeats, then tap B
+    const auto recorded = session([&] {
+        CHECK(gamepad::master.start_recording(path));
+        for (int tick = 0; tick < 120; ++tick) {
+            gamepad::sim::set_button(MASTER, pros::E_CONTROLLER_DIGITAL_A, tick >= 5 && tick < 80);
+            gamepad::sim::set_button(MASTER, pros::E_CONTROLLER_DIGITAL_B, tick >= 90 && tick < 95);
+            gamepad::sim::advance(10);
+            gamepad::master.update();
+        }
+        gamepad::master.stop_recording();
+    });
+    for (int i = 0; i < 500 && gamepad::master.is_recording(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    CHECK(!gamepad::master.is_recording());
+    CHECK(recorded.size() > 6);
+
+    // the replay is updated late and unevenly, which must not change which events fire or when
+    gamepad::Replay replay;
+    CHECK(replay.open(path));
+    gamepad::master.set_input_source(&replay);
+    const auto replayed = session([&] {
+        for (int tick = 0; !replay.is_finished(); ++tick) {
+            gamepad::sim::advance(tick % 3 == 0 ? 35 : 1);
+            gamepad::master.update();
+        }
+    });
+    gamepad::master.set_input_source(nullptr);
+    CHECK(replayed == recorded);
+    replay.close();
+    std::remove(path);
+}
+} // namespace
+
+int main() {
+    round_trip();
+    truncated();
+    leading_repeat();
+    replay_disconnects_at_the_end();
+    replay_fires_the_recorded_events();
+    return gamepad::test::failures != 0;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+
+#include "pros/misc.h"
+
+namespace gamepad {
+/**
+ * @brief A handle to one of a gamepad's logical actions, see Gamepad::action()
+ *
+ * A default constructed action is invalid, and is never held.
+ */
+class Action {
+        friend class Gamepad;
+    public:
+        constexpr Action() = default;
+
+        /**
+         * @brief Gets the index of the action in the gamepad's action bitset
+         */
+        constexpr uint8_t index() const { return this->id; }
+
+        /**
+         * @brief Whether or not this handle refers to an action
+         */
+        constexpr bool is_valid() const { return this->id != UINT8_MAX; }
+
+        constexpr bool operator==(const Action& other) const = default;
+    private:
+        constexpr explicit Action(uint8_t id)
+            : id(id) {}
+
+        uint8_t id = UINT8_MAX;
+};
+
+/**
+ * @brief A physical input that an action can be bound to
+ *
+ * @b Example:
+ * @code {.cpp}
+ *   gamepad::Input::button(DIGITAL_R1); // R1 is held
+ *   gamepad::Input::chord({DIGITAL_L1, DIGITAL_R1}); // both L1 and R1 are held
+ *   gamepad::Input::axis(ANALOG_RIGHT_Y, -100); // the right joystick is pushed almost all the way down
+ * @endcode
+ */
+struct Input {
+        /**
+         * @brief An input that is active while a button is held
+         *
+         * @param button Which button
+         */
+        static constexpr Input button(pros::controller_digital_e_t button) { return chord({button}); }
+
+        /**
+         * @brief An input that is active while every one of a set of buttons is held
+         *
+         * @param buttons Which buttons
+         */
+        static constexpr Input chord(std::initializer_list<pros::controller_digital_e_t> buttons) {
+            Input input;
+            for (auto button : buttons) input.buttons |= 1 << (button - pros::E_CONTROLLER_DIGITAL_L1);
+            return input;
+        }
+
+        /**
+         * @brief An input that is active while a joystick axis is past a threshold
+         *
+         * @param axis Which joystick axis
+         * @param threshold A positive threshold is active when the axis is at or above it, a negative threshold is
+         * active when the axis is at or below it, and a threshold of 0 is active when the axis is above 0
+         */
+        static constexpr Input axis(pros::controller_analog_e_t axis, float threshold) {
+            Input input;
+            input.joystick = axis;
+            input.threshold = threshold;
+            return input;
+        }
+
+        /**
+         * @brief Whether or not the input is active
+         *
+         * @param held_buttons Which buttons are held, bit i is set if button DIGITAL_L1 + i is held
+         * @param axes The values of the joystick axes, indexed by pros::controller_analog_e_t
+         * @return true The input is active
+         * @return false The input is not active
+         */
+        constexpr bool is_active(uint16_t held_buttons, const float (&axes)[4]) const {
+            if (this->buttons) return (held_buttons & this->buttons) == this->buttons;
+            if (this->joystick < 0 || this->joystick > 3) return false;
+            const float value = axes[this->joystick];
+            // a centered joystick must not count as being pushed past a threshold of 0
+            if (this->threshold == 0) return value > 0;
+            return this->threshold > 0 ? value >= this->threshold : value <= this->threshold;
+        }
+
+        /// Which buttons must be held, bit i is DIGITAL_L1 + i
+        uint16_t buttons = 0;
+        /// Which joystick axis is checked against the threshold, if no buttons are set
+        int8_t joystick = -1;
+        /// How far the joystick axis must be pushed
+        float threshold = 0;
+};
+} // namespace gamepad
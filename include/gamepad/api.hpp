@@ -1,4 +1,5 @@
 #pragma once
 
 #include "gamepad/event_handler.hpp" // IWYU pragma: export
-#include "gamepad/controller.hpp" // IWYU pragma: export
\ No newline at end of file
+#include "gamepad/controller.hpp" // IWYU pragma: export
+#include "gamepad/menu.hpp" // IWYU pragma: export
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <type_traits>
+
+#include "gamepad/button.hpp"
+#include "pros/misc.h"
+
+namespace gamepad {
+/**
+ * @brief A listener bound to a button event at compile time, for use in a @ref BindingTable
+ *
+ * @tparam button_id Which button the function is bound to
+ * @tparam event_type Which event of the button the function runs on
+ * @tparam function The function to run, it can either take no parameters or a const ButtonEvent&, and MUST NOT block
+ */
+template <pros::controller_digital_e_t button_id, EventType event_type, auto function> struct Binding {
+        static_assert(button_id >= pros::E_CONTROLLER_DIGITAL_L1 && button_id <= pros::E_CONTROLLER_DIGITAL_A,
+                      "gamepad: a binding must be bound to one of the digital buttons");
+        static_assert(std::is_invocable_v<decltype(function)> ||
+                          std::is_invocable_v<decltype(function), const ButtonEvent&>,
+                      "gamepad: a bound function must take either no parameters or a const ButtonEvent&");
+        /// Which button the function is bound to
+        static constexpr pros::controller_digital_e_t button = button_id;
+        /// Which event of the button the function runs on
+        static constexpr EventType event = event_type;
+        /// The function to run
+        static constexpr auto func = function;
+        /// Whether the function takes the details of the event
+        static constexpr bool takes_details = std::is_invocable_v<decltype(function), const ButtonEvent&>;
+};
+
+/**
+ * @brief A set of listeners that are fixed at compile time
+ *
+ * A binding table has no registration, no listener names and no type erasure: Gamepad::update<Table>() checks
+ * which events fired and calls each bound function directly, so the calls can be inlined.
+ *
+ * @tparam Bindings The @ref Binding "Bindings" in the table
+ *
+ * @b Example:
+ * @code {.cpp}
+ *   using Controls = gamepad::BindingTable<gamepad::Binding<DIGITAL_A, gamepad::ON_PRESS, fireCatapult>,
+ *                                          gamepad::Binding<DIGITAL_L1, gamepad::ON_RELEASE, stopIntake>>;
+ *
+ *   while (true) {
+ *       gamepad::master.update<Controls>();
+ *       pros::delay(25);
+ *   }
+ * @endcode
+ */
+template <typename... Bindings> struct BindingTable {};
+} // namespace gamepad
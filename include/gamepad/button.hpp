@@ -1,9 +1,10 @@
 #pragma once
 
 #include <cstdint>
-#include <functional>
 #include <string>
+#include <vector>
 
+#include "coroutine.hpp"
 #include "event_handler.hpp"
 
 namespace gamepad {
@@ -16,6 +17,55 @@ enum EventType {
     ON_REPEAT_PRESS,
 };
 
+/**
+ * @brief How a button makes up for repeat presses that were missed because update() was called late
+ */
+enum CatchUpPolicy {
+    /// Fire at most one repeat press per update, any other missed repeat presses are dropped (default)
+    CATCH_UP_DROP,
+    /// Fire one repeat press for every repeat interval that elapsed since the last update
+    CATCH_UP_FIRE_ALL,
+    /// Fire a single repeat press that stands in for every repeat interval that elapsed since the last update
+    CATCH_UP_COALESCE,
+};
+
+/**
+ * @brief The details of a button event, passed to listeners that accept it
+ */
+struct ButtonEvent {
+        /// Which event was fired
+        EventType type;
+        /// When the event was fired, in ms since the program started
+        uint32_t timestamp = 0;
+        /// How long the button had been held when the event was fired, in ms (0 for ON_PRESS)
+        uint32_t time_held = 0;
+        /// Which repeat press this is, starting at 1 (only set for ON_REPEAT_PRESS)
+        uint32_t repeat_iterations = 0;
+        /// How many repeat intervals this repeat press accounts for (only set for ON_REPEAT_PRESS)
+        uint32_t repeat_count = 0;
+        /// Whether a listener has consumed the event
+        mutable bool consumed = false;
+
+        /**
+         * @brief Stops the event from reaching any listeners with a lower priority, or any binding table
+         *
+         * @b Example:
+         * @code {.cpp}
+         *   // while the menu is open, drive controls never see the A button
+         *   gamepad::master.A.onPress("menuSelect", [](const gamepad::ButtonEvent& event) {
+         *       if (menu_open) {
+         *           menu.select();
+         *           event.consume();
+         *       }
+         *   }, {.priority = 10});
+         * @endcode
+         */
+        void consume() const { this->consumed = true; }
+};
+
+/// A function to run when a button event is fired, it can either take no parameters or a const ButtonEvent&
+using ButtonListener = _impl::EventHandler<std::string, const ButtonEvent&>::Listener;
+
 class Button {
         friend class Gamepad;
     public:
@@ -31,6 +81,8 @@ class Button {
         uint32_t time_released = 0;
         /// How many times the button has been repeat-pressed
         uint32_t repeat_iterations = 0;
+        /// How many repeat intervals the last repeat press accounts for (only above 1 with CATCH_UP_COALESCE)
+        uint32_t repeat_count = 0;
         /**
          * @brief Set the time for a press to be considered a long press for the button
          *
@@ -68,11 +120,36 @@ class Button {
          * @endcode
          */
         void set_repeat_cooldown(uint32_t cooldown) const;
+        /**
+         * @brief Set how missed repeat presses are handled when update() is called late
+         *
+         * If the update loop stalls for longer than the repeat cooldown, several repeat presses become due at
+         * once. By default only one of them is fired, with CATCH_UP_FIRE_ALL every missed repeat press is fired and
+         * with CATCH_UP_COALESCE one repeat press is fired with repeat_count set to the number of missed repeats.
+         *
+         * @note with CATCH_UP_FIRE_ALL or CATCH_UP_COALESCE, the long press and repeat schedule is anchored to when
+         * the long press threshold was actually crossed, so the first repeat press fires in the same update as the
+         * long press
+         *
+         * @param policy the catch-up policy to use
+         *
+         * @b Example:
+         * @code {.cpp}
+         *   // never lose a nudge, even if the loop stalls
+         *   gamepad::master.Up.set_catch_up_policy(gamepad::CATCH_UP_COALESCE);
+         *   gamepad::master.Up.onRepeatPress("nudgeLift", []() {
+         *       lift_target += 5 * gamepad::master.Up.repeat_count;
+         *   });
+         * @endcode
+         */
+        void set_catch_up_policy(CatchUpPolicy policy) const;
         /**
          * @brief Register a function to run when the button is pressed.
          *
          * @param listenerName The name of the listener, this must be a unique name
          * @param func The function to run when the button is pressed, the function MUST NOT block
+         * and can optionally take the details of the event as a const ButtonEvent&
+         * @param options Optional settings for the listener, such as its priority
          * @return true The listener was successfully registered
          * @return false The listener was not successfully registered (there is already a listener with this name)
          *
@@ -82,9 +159,13 @@ class Button {
          *   gamepad::master.Down.onPress("downPress1", downPress1);
          *   // ...or a lambda
          *   gamepad::master.Up.onPress("upPress1", []() { std::cout << "I was pressed!" << std::endl; });
+         *   // ...which can also take the details of the event
+         *   gamepad::master.Up.onPress("logPress", [](const gamepad::ButtonEvent& event) {
+         *       std::cout << "Pressed at " << event.timestamp << "ms" << std::endl;
+         *   });
          * @endcode
          */
-        bool onPress(std::string listenerName, std::function<void(void)> func) const;
+        bool onPress(std::string listenerName, ButtonListener func, ListenerOptions options = {}) const;
         /**
          * @brief Register a function to run when the button is long pressed.
          *
@@ -96,6 +177,8 @@ class Button {
          *
          * @param listenerName The name of the listener, this must be a unique name
          * @param func The function to run when the button is long pressed, the function MUST NOT block
+         * and can optionally take the details of the event as a const ButtonEvent&
+         * @param options Optional settings for the listener, such as its priority
          * @return true The listener was successfully registered
          * @return false The listener was not successfully registered (there is already a listener with this name)
          *
@@ -106,14 +189,20 @@ class Button {
          *   // ...or a lambda
          *   gamepad::master.Right.onLongPress("print_right", []() { std::cout << "Right button was long pressed!" <<
          * std::endl; });
+         *   // ...which can also take the details of the event
+         *   gamepad::master.Left.onLongPress("logLongPress", [](const gamepad::ButtonEvent& event) {
+         *       std::cout << "Held for " << event.time_held << "ms" << std::endl;
+         *   });
          * @endcode
          */
-        bool onLongPress(std::string listenerName, std::function<void(void)> func) const;
+        bool onLongPress(std::string listenerName, ButtonListener func, ListenerOptions options = {}) const;
         /**
          * @brief Register a function to run when the button is released.
          *
          * @param listenerName The name of the listener, this must be a unique name
          * @param func The function to run when the button is released, the function MUST NOT block
+         * and can optionally take the details of the event as a const ButtonEvent&
+         * @param options Optional settings for the listener, such as its priority
          * @return true The listener was successfully registered
          * @return false The listener was not successfully registered (there is already a listener with this name)
          *
@@ -123,9 +212,13 @@ class Button {
          *   gamepad::master.X.onRelease("stopFlywheel", stopFlywheel);
          *   // ...or a lambda
          *   gamepad::master.Y.onRelease("stopIntake", []() { intake.move(0); });
+         *   // ...which can also take the details of the event
+         *   gamepad::master.Y.onRelease("logRelease", [](const gamepad::ButtonEvent& event) {
+         *       std::cout << "Released after " << event.time_held << "ms" << std::endl;
+         *   });
          * @endcode
          */
-        bool onRelease(std::string listenerName, std::function<void(void)> func) const;
+        bool onRelease(std::string listenerName, ButtonListener func, ListenerOptions options = {}) const;
         /**
          * @brief Register a function to run when the button is short released.
          *
@@ -136,6 +229,8 @@ class Button {
          *
          * @param listenerName The name of the listener, this must be a unique name
          * @param func The function to run when the button is short released, the function MUST NOT block
+         * and can optionally take the details of the event as a const ButtonEvent&
+         * @param options Optional settings for the listener, such as its priority
          * @return true The listener was successfully registered
          * @return false The listener was not successfully registered (there is already a listener with this name)
          *
@@ -145,9 +240,13 @@ class Button {
          *   gamepad::master.A.onShortRelease("raiseLiftOneLevel", raiseLiftOneLevel);
          *   // ...or a lambda
          *   gamepad::master.B.onShortRelease("intakeOnePiece", []() { intake.move_relative(600, 100); });
+         *   // ...which can also take the details of the event
+         *   gamepad::master.B.onShortRelease("tap", [](const gamepad::ButtonEvent& event) {
+         *       std::cout << "Tapped for " << event.time_held << "ms" << std::endl;
+         *   });
          * @endcode
          */
-        bool onShortRelease(std::string listenerName, std::function<void(void)> func) const;
+        bool onShortRelease(std::string listenerName, ButtonListener func, ListenerOptions options = {}) const;
         /**
          * @brief Register a function to run when the button is long released.
          *
@@ -156,6 +255,8 @@ class Button {
          *
          * @param listenerName The name of the listener, this must be a unique name
          * @param func The function to run when the button is long released, the function MUST NOT block
+         * and can optionally take the details of the event as a const ButtonEvent&
+         * @param options Optional settings for the listener, such as its priority
          * @return true The listener was successfully registered
          * @return false The listener was not successfully registered (there is already a listener with this name)
          *
@@ -165,10 +266,14 @@ class Button {
          *   gamepad::master.Up.onLongRelease("moveLiftToGround", moveLiftToGround);
          *   // ...or a lambda
          *   gamepad::master.Left.onLongRelease("spinIntake", []() { intake.move(127); });
+         *   // ...which can also take the details of the event
+         *   gamepad::master.Left.onLongRelease("hold", [](const gamepad::ButtonEvent& event) {
+         *       std::cout << "Held for " << event.time_held << "ms" << std::endl;
+         *   });
          * @endcode
          *
          */
-        bool onLongRelease(std::string listenerName, std::function<void(void)> func) const;
+        bool onLongRelease(std::string listenerName, ButtonListener func, ListenerOptions options = {}) const;
         /**
          * @brief Register a function to run periodically after its been held
          *
@@ -177,6 +282,8 @@ class Button {
          *
          * @param listenerName The name of the listener, this must be a unique name
          * @param func the function to run periodically when the button is held, the function MUST NOT block
+         * and can optionally take the details of the event as a const ButtonEvent&
+         * @param options Optional settings for the listener, such as its priority
          * @return true The listener was successfully registered
          * @return false The listener was not successfully registered (there is already a listener with this name)
          *
@@ -186,16 +293,22 @@ class Button {
          *   gamepad::master.X.onRepeatPress("shootDisk", shootOneDisk);
          *   // ...or a lambda
          *   gamepad::master.A.onRepeatPress("scoreOneRing", []() { intake.move_relative(200, 100); });
+         *   // ...which can also take the details of the event
+         *   gamepad::master.Up.onRepeatPress("nudgeLift", [](const gamepad::ButtonEvent& event) {
+         *       lift_target += 5 * event.repeat_count;
+         *   });
          * @endcode
          *
          */
-        bool onRepeatPress(std::string listenerName, std::function<void(void)> func) const;
+        bool onRepeatPress(std::string listenerName, ButtonListener func, ListenerOptions options = {}) const;
         /**
          * @brief Register a function to run for a given event.
          *
          * @param event Which event to register the listener on.
          * @param listenerName The name of the listener, this must be a unique name
          * @param func The function to run for the given event, the function MUST NOT block
+         * and can optionally take the details of the event as a const ButtonEvent&
+         * @param options Optional settings for the listener, such as its priority
          * @return true The listener was successfully registered
          * @return false The listener was not successfully registered (there is already a listener with this name)
          *
@@ -205,9 +318,14 @@ class Button {
          *   gamepad::master.L1.addListener(gamepad::ON_PRESS, "start_spin", startSpin);
          *   // ...or a lambda
          *   gamepad::master.L1.addListener(gamepad::ON_RELEASE, "stop_spin", []() { motor1.brake(); });
+         *   // ...which can also take the details of the event
+         *   gamepad::master.L1.addListener(gamepad::ON_RELEASE, "log_spin", [](const gamepad::ButtonEvent& event) {
+         *       std::cout << "Spun for " << event.time_held << "ms" << std::endl;
+         *   });
          * @endcode
          */
-        bool addListener(EventType event, std::string listenerName, std::function<void(void)> func) const;
+        bool addListener(EventType event, std::string listenerName, ButtonListener func,
+                         ListenerOptions options = {}) const;
         /**
          * @brief Removes a listener from the button
          * @warning Usage of this function is discouraged.
@@ -225,6 +343,84 @@ class Button {
          * @endcode
          */
         bool removeListener(std::string listenerName) const;
+        /**
+         * @brief Gets how contended the lock on an event's listeners has been
+         *
+         * @note the library must be compiled with GAMEPAD_MUTEX_STATS defined, otherwise the stats are always 0
+         *
+         * @param event Which event to get the stats of
+         * @return MutexStats The contention statistics of the event's listener lock
+         *
+         * @b Example:
+         * @code {.cpp}
+         *   gamepad::MutexStats stats = gamepad::master.A.lock_stats(gamepad::ON_PRESS);
+         *   printf("A press: %lu/%lu contended, %llu us waited\n", stats.contentions, stats.acquisitions,
+         *          stats.total_wait);
+         * @endcode
+         */
+        MutexStats lock_stats(EventType event) const;
+        /**
+         * @brief Blocks the calling task until an event is fired, or until a timeout
+         *
+         * The task sleeps until it is notified by the event, so it does not use any CPU time while waiting. The
+         * event wakes the task even if a listener consumes it, and regardless of which input contexts are active.
+         *
+         * @warning this MUST NOT be called from the task that updates the gamepad, or from a listener, since the event
+         * could then never be fired
+         * @note this uses the calling task's notification value, and clears it before waiting
+         *
+         * @param event Which event to wait for
+         * @param timeout How long to wait for the event, in ms
+         * @return true The event was fired
+         * @return false The event was not fired before the timeout
+         *
+         * @b Example:
+         * @code {.cpp}
+         *   // wait for the driver to confirm the selected auton, for up to 5 seconds
+         *   if (gamepad::master.A.wait_for(gamepad::ON_PRESS, 5000)) runAuton();
+         * @endcode
+         */
+        bool wait_for(EventType event, uint32_t timeout = TIMEOUT_MAX) const;
+        /**
+         * @brief Suspends a @ref Macro until an event is fired, without blocking the task that is running it
+         *
+         * Like wait_for(), the event resumes the macro even if a listener consumes it, and regardless of which input
+         * contexts are active. The macro is resumed at the end of the Gamepad::update() that fired the event.
+         *
+         * @param event Which event to wait for
+         * @return An awaitable that gives the details of the event
+         *
+         * @b Example:
+         * @code {.cpp}
+         *   gamepad::Macro tuneLift() {
+         *       while (true) {
+         *           gamepad::ButtonEvent event = co_await gamepad::master.Up.next(gamepad::ON_LONG_RELEASE);
+         *           liftGain += event.time_held / 1000.0;
+         *       }
+         *   }
+         * @endcode
+         */
+        [[nodiscard]] _impl::EventAwaiter<ButtonEvent> next(EventType event) const {
+            return {this->get_handler(event), this->scheduler};
+        }
+        /**
+         * @brief Suspends a @ref Macro until the button is pressed, same as next(ON_PRESS)
+         *
+         * @b Example:
+         * @code {.cpp}
+         *   co_await gamepad::master.A.pressed();
+         * @endcode
+         */
+        [[nodiscard]] _impl::EventAwaiter<ButtonEvent> pressed() const { return this->next(ON_PRESS); }
+        /**
+         * @brief Suspends a @ref Macro until the button is released, same as next(ON_RELEASE)
+         *
+         * @b Example:
+         * @code {.cpp}
+         *   co_await gamepad::master.A.released();
+         * @endcode
+         */
+        [[nodiscard]] _impl::EventAwaiter<ButtonEvent> released() const { return this->next(ON_RELEASE); }
 
         /**
          * @brief Returns a value indicating whether the button is currently being held.
@@ -235,26 +431,94 @@ class Button {
         explicit operator bool() const { return is_pressed; }
     private:
         /**
-         * @brief Updates the button and runs any event handlers, if necessary
+         * @brief Updates the state of the button, without running any event handlers
          *
          * @param is_held Whether or not the button is currently held down
+         * @param now The time the button was sampled at, in ms
+         */
+        void sample(bool is_held, uint32_t now);
+        /**
+         * @brief Runs any event handlers for the last sample, if necessary
+         *
+         * @param now The time the button was sampled at, in ms
+         * @param contexts The mask of the gamepad's active input contexts
+         */
+        void fire(uint32_t now, uint32_t contexts);
+        /**
+         * @brief Resets the button to released, without running any event handlers
+         *
+         * @param now The current time in ms
+         */
+        void reset(uint32_t now);
+        /**
+         * @brief Keeps the button held or released for an update where it could not be read, so that nothing is
+         * reported as pressed, released or fired during that update
+         */
+        void hold();
+        /**
+         * @brief Fires the repeat press event for every repeat press that is due, according to the catch-up policy
+         *
+         * @param now The current time in ms
+         * @param contexts The mask of the gamepad's active input contexts
+         */
+        void fire_repeat_press(uint32_t now, uint32_t contexts);
+        /**
+         * @brief Builds the details of an event from the current state of the button
+         *
+         * @param event Which event to build the details of
+         * @param timestamp When the event was fired, in ms
+         * @return ButtonEvent The details to pass to the event's listeners
+         */
+        ButtonEvent event_details(EventType event, uint32_t timestamp) const;
+        /**
+         * @brief Gets how many times an event was fired and not consumed during the last update
+         *
+         * @param event Which event to check
+         * @return uint32_t How many times the event was fired, this is only ever above 1 for repeat presses
+         */
+        uint32_t times_fired(EventType event) const {
+            if (event == ON_REPEAT_PRESS) return this->repeats_fired.size();
+            return (this->fired_events >> event) & 1;
+        }
+        /**
+         * @brief Rebuilds the details of an event that was fired during the last update
+         *
+         * @param event Which event to get the details of
+         * @param index Which firing of the event to get the details of, if it was fired more than once
+         * @return ButtonEvent The details the event's listeners were passed
+         */
+        ButtonEvent fired_event(EventType event, uint32_t index) const;
+        /**
+         * @brief Gets the listeners of an event
+         *
+         * @param event Which event to get the listeners of
+         * @return The listeners, or nullptr if the event is invalid
          */
-        void update(bool is_held);
+        _impl::EventHandler<std::string, const ButtonEvent&>* get_handler(EventType event) const;
         /// How long the threshold should be for the longPress and shortRelease events
         mutable uint32_t long_press_threshold = 500;
         /// How often repeatPress is called
         mutable uint32_t repeat_cooldown = 50;
+        /// How repeat presses missed by a late update are handled
+        mutable CatchUpPolicy catch_up_policy = CATCH_UP_DROP;
         /// The last time the update function was called
         uint32_t last_update_time = pros::millis();
         /// The last time the long press event was fired
         uint32_t last_long_press_time = 0;
         /// The last time the repeat event was called
         uint32_t last_repeat_time = 0;
-        mutable _impl::EventHandler<std::string> onPressEvent {};
-        mutable _impl::EventHandler<std::string> onLongPressEvent {};
-        mutable _impl::EventHandler<std::string> onReleaseEvent {};
-        mutable _impl::EventHandler<std::string> onShortReleaseEvent {};
-        mutable _impl::EventHandler<std::string> onLongReleaseEvent {};
-        mutable _impl::EventHandler<std::string> onRepeatPressEvent {};
+        /// Which events were fired and not consumed during the last update, one bit per EventType
+        uint8_t fired_events = 0;
+        /// The repeat_iterations of each repeat press that was fired and not consumed during the last update, which
+        /// keeps its capacity between updates
+        std::vector<uint32_t> repeats_fired {};
+        mutable _impl::EventHandler<std::string, const ButtonEvent&> onPressEvent {};
+        mutable _impl::EventHandler<std::string, const ButtonEvent&> onLongPressEvent {};
+        mutable _impl::EventHandler<std::string, const ButtonEvent&> onReleaseEvent {};
+        mutable _impl::EventHandler<std::string, const ButtonEvent&> onShortReleaseEvent {};
+        mutable _impl::EventHandler<std::string, const ButtonEvent&> onLongReleaseEvent {};
+        mutable _impl::EventHandler<std::string, const ButtonEvent&> onRepeatPressEvent {};
+        /// The scheduler of the gamepad that owns the button, which resumes the macros waiting on it
+        _impl::Scheduler* scheduler = nullptr;
 };
 } // namespace gamepad
\ No newline at end of file
@@ -1,19 +1,50 @@
 #pragma once
 
 #include "pros/misc.h"
+#include <array>
+#include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "action.hpp"
+#include "binding_table.hpp"
 #include "button.hpp"
+#include "input_source.hpp"
+#include "recording.hpp"
+#include "rumble.hpp"
+#include "screen.hpp"
+#include "seqlock.hpp"
+#include "state.hpp"
 #include "pros/misc.hpp"
+#include "pros/rtos.h"
 
 namespace gamepad {
+/// A function to run when the connection or battery of a gamepad changes
+using GamepadListener = _impl::EventHandler<std::string>::Listener;
+
+/**
+ * @brief What happens to the inputs of a gamepad while its controller is disconnected
+ */
+enum DisconnectPolicy {
+    /// Every button is released and every joystick is centered, without firing any release events. Buttons that are
+    /// still held when the controller reconnects are ignored until they are released
+    DISCONNECT_ZERO,
+    /// Every button and joystick keeps its last value, and the buttons resume from that state when the controller
+    /// reconnects
+    DISCONNECT_FREEZE,
+};
+
 class Gamepad {
+        friend void update_all();
+        friend _impl::Scheduler& _impl::default_scheduler();
     public:
         /**
          * @brief Updates the state of the gamepad (all joysticks and buttons), and also runs
          * any registered listeners.
          *
-         * @note This function should be called at the beginning of every loop iteration.
+         * @note This function should be called at the beginning of every loop iteration, unless the gamepad is
+         * being polled by start_polling(), in which case calling it from any other task does nothing.
          *
          * @b Example:
          * @code {.cpp}
@@ -26,6 +57,37 @@ class Gamepad {
          *
          */
         void update();
+        /**
+         * @brief Updates the state of the gamepad and runs any registered listeners, then runs the functions of a
+         * compile-time binding table for every event that was fired.
+         *
+         * Runtime listeners (onPress() and the like) still run first. An event with no runtime listeners costs a
+         * single atomic load instead of a lock and a walk of its listeners, so a gamepad that is only driven by
+         * binding tables doesn't pay for runtime dispatch.
+         *
+         * @note Like update(), this does nothing if the gamepad is being polled by start_polling(), and the table is
+         * not run either.
+         *
+         * @tparam Table The @ref BindingTable to run
+         *
+         * @b Example:
+         * @code {.cpp}
+         * using Controls = gamepad::BindingTable<gamepad::Binding<DIGITAL_A, gamepad::ON_PRESS, fireCatapult>>;
+         *
+         * while (true) {
+         *   gamepad::master.update<Controls>();
+         *   // do robot control stuff here...
+         *   pros::delay(25);
+         * }
+         * @endcode
+         *
+         */
+        template <typename Table> void update() {
+            // a polled gamepad is updated by the polling task, so its events belong to that task's update
+            if (!this->can_update()) return;
+            this->run_update();
+            this->dispatch(Table {});
+        }
         /**
          * @brief Get the state of a button on the controller.
          *
@@ -53,6 +115,389 @@ class Gamepad {
          *
          */
         float operator[](pros::controller_analog_e_t joystick);
+        /**
+         * @brief Start updating the gamepad periodically from a task owned by the library.
+         *
+         * Listeners then run in that task, and any other task can read the state of the gamepad through snapshot()
+         * instead of calling update() itself. Calling this again while polling changes the period.
+         *
+         * @param period How often the gamepad is updated, in ms
+         * @param priority The priority of the polling task
+         * @return true The gamepad is being polled
+         * @return false The polling task could not be created (errno is set by pros::Task::create)
+         *
+         * @b Example:
+         * @code {.cpp}
+         * void initialize() {
+         *   gamepad::master.start_polling(10);
+         * }
+         *
+         * void opcontrol() {
+         *   while (true) {
+         *     gamepad::GamepadState state = gamepad::master.snapshot();
+         *     chassis.arcade(state.LeftY, state.RightX);
+         *     pros::delay(10);
+         *   }
+         * }
+         * @endcode
+         *
+         */
+        bool start_polling(uint32_t period = 10, uint32_t priority = TASK_PRIORITY_DEFAULT);
+        /**
+         * @brief Stop updating the gamepad from the polling task, update() must be called manually again.
+         *
+         */
+        void stop_polling();
+        /**
+         * @brief Get a copy of the state of the gamepad as of the last update, which is safe to call from any task.
+         *
+         * The copy is always from a single update, unlike reading the public members of the gamepad while another
+         * task is updating it. This never blocks, and does not take a mutex.
+         *
+         * @return GamepadState The state of the buttons, joysticks and actions
+         *
+         * @b Example:
+         * @code {.cpp}
+         * // in the odometry task, while opcontrol() is calling gamepad::master.update()
+         * gamepad::GamepadState state = gamepad::master.snapshot();
+         * if (state.is_held(DIGITAL_B) && state[DIGITAL_B].time_held > 1000) odom.reset();
+         * @endcode
+         */
+        GamepadState snapshot() const;
+        /**
+         * @brief Set the minimum time between sending anything to the controller
+         *
+         * Text for the screen and rumble patterns share one link to the controller, and update() sends at most one of
+         * them per period. A rumble pattern that is due is sent before any text.
+         *
+         * @param period The time in ms, the default of 50 ms works over VEXnet, while 10 ms works with a cable
+         */
+        void set_send_period(uint32_t period);
+        /**
+         * @brief Whether or not the controller was connected when it was last checked.
+         *
+         * The connection is checked by every update(), and the battery every status period (see set_status_period()),
+         * so this is cheap to call every loop.
+         *
+         * @return true The controller is connected
+         * @return false The controller is not connected
+         */
+        bool is_connected() const { return this->connected.load(std::memory_order_relaxed); }
+        /**
+         * @brief Get the controller's battery capacity as of when it was last checked.
+         *
+         * @return int32_t The battery capacity, in percent
+         */
+        int32_t battery_capacity() const { return this->capacity.load(std::memory_order_relaxed); }
+        /**
+         * @brief Get the controller's battery level as of when it was last checked.
+         *
+         * @return int32_t The battery level
+         */
+        int32_t battery_level() const { return this->level.load(std::memory_order_relaxed); }
+        /**
+         * @brief Set how often update() checks the controller's battery, the connection is checked every update.
+         *
+         * @param period The time in ms, 500 ms by default
+         */
+        void set_status_period(uint32_t period);
+        /**
+         * @brief Set what happens to the inputs while the controller is disconnected.
+         *
+         * A disconnected controller reads as if every button was let go, which would otherwise fire release events in
+         * the middle of whatever the driver was doing. No button events are fired while the controller is
+         * disconnected, whichever policy is used.
+         *
+         * @param policy The policy, DISCONNECT_ZERO by default
+         *
+         * @b Example:
+         * @code {.cpp}
+         * // keep the lift held up if the controller drops out for a moment
+         * gamepad::master.set_disconnect_policy(gamepad::DISCONNECT_FREEZE);
+         * @endcode
+         *
+         */
+        void set_disconnect_policy(DisconnectPolicy policy);
+        /**
+         * @brief Set the battery capacity that fires the low battery event.
+         *
+         * The event fires once when the capacity drops below the threshold, and again only after the capacity has
+         * risen at least 5% above it, so a capacity that wavers around the threshold does not fire it repeatedly.
+         *
+         * @param threshold The battery capacity, in percent, 20% by default
+         */
+        void set_low_battery_threshold(int32_t threshold);
+        /**
+         * @brief Register a function to run when the controller disconnects.
+         *
+         * @param listenerName The name of the listener, this must be a unique name
+         * @param func The function to run when the controller disconnects, the function MUST NOT block
+         * @param options Optional settings for the listener, such as its priority
+         * @return true The listener was successfully registered
+         * @return false The listener was not successfully registered (there is already a listener with this name)
+         *
+         * @b Example:
+         * @code {.cpp}
+         * gamepad::master.onDisconnect("stop", []() { chassis.brake(); });
+         * @endcode
+         *
+         */
+        bool onDisconnect(std::string listenerName, GamepadListener func, ListenerOptions options = {});
+        /**
+         * @brief Register a function to run when the controller reconnects.
+         *
+         * @param listenerName The name of the listener, this must be a unique name
+         * @param func The function to run when the controller reconnects, the function MUST NOT block
+         * @param options Optional settings for the listener, such as its priority
+         * @return true The listener was successfully registered
+         * @return false The listener was not successfully registered (there is already a listener with this name)
+         */
+        bool onReconnect(std::string listenerName, GamepadListener func, ListenerOptions options = {});
+        /**
+         * @brief Register a function to run when the controller's battery drops below the low battery threshold.
+         *
+         * @param listenerName The name of the listener, this must be a unique name
+         * @param func The function to run when the battery is low, the function MUST NOT block
+         * @param options Optional settings for the listener, such as its priority
+         * @return true The listener was successfully registered
+         * @return false The listener was not successfully registered (there is already a listener with this name)
+         *
+         * @b Example:
+         * @code {.cpp}
+         * gamepad::master.onLowBattery("warn", []() { gamepad::master.rumble.play("...", 5); });
+         * @endcode
+         *
+         */
+        bool onLowBattery(std::string listenerName, GamepadListener func, ListenerOptions options = {});
+        /**
+         * @brief Removes a connection or battery listener from the gamepad.
+         *
+         * @param listenerName The name of the listener to remove
+         * @return true The specified listener was successfully removed
+         * @return false The specified listener could not be removed
+         */
+        bool removeListener(std::string listenerName);
+        /**
+         * @brief Start recording the buttons and joysticks of every update to a file.
+         *
+         * Updates are compressed into a buffer in RAM, and a low priority task writes the buffer to the file in
+         * blocks, so recording never makes update() wait on the SD card. Only what changes between updates is stored,
+         * so a controller that is left alone costs almost nothing. If the SD card can't keep up and the buffer fills,
+         * the recording stops early, and everything before that is still saved.
+         *
+         * @param path The path of the file, which is replaced if it already exists
+         * @param buffer_size How many bytes can wait in RAM to be written to the file, at least 512
+         * @return true Recording started
+         * @return false A recording is still being written (errno is set to EBUSY), the buffer is too small (errno is
+         * set to EINVAL), or the file could not be opened (errno is set by fopen)
+         *
+         * @b Example:
+         * @code {.cpp}
+         * void opcontrol() {
+         *   gamepad::master.start_recording("/usd/match.gpr");
+         *   while (true) {
+         *     gamepad::master.update();
+         *     // do robot control stuff here...
+         *     pros::delay(10);
+         *   }
+         * }
+         *
+         * void disabled() { gamepad::master.stop_recording(); }
+         * @endcode
+         *
+         */
+        bool start_recording(const char* path, size_t buffer_size = 4096);
+        /**
+         * @brief Stop recording, the rest of the recording is written to the file in the background.
+         *
+         */
+        void stop_recording();
+        /**
+         * @brief Whether or not a recording is in progress, or is still being written to the file.
+         *
+         * @return true The gamepad is being recorded, or the file has not been closed yet
+         * @return false The last recording has been completely written
+         */
+        bool is_recording() const;
+        /**
+         * @brief Read the buttons and joysticks from somewhere other than the controller.
+         *
+         * The connection and battery are still read from the controller, but the inputs are read from the source,
+         * and the source decides whether the inputs count as disconnected. Every update() reads the source once.
+         *
+         * @param source The source, which must stay alive until it is replaced, or nullptr to read from the
+         * controller again
+         *
+         * @b Example:
+         * @code {.cpp}
+         * gamepad::Replay replay;
+         * replay.open("/usd/match.gpr");
+         * // the listeners fire just like they did during the match
+         * gamepad::master.set_input_source(&replay);
+         * @endcode
+         *
+         */
+        void set_input_source(InputSource* source);
+        /**
+         * @brief Get one of the gamepad's input contexts by name, creating it if it does not exist yet.
+         *
+         * Listeners registered with a context only run while that context is active, so switching between control
+         * schemes is a single push_context() or set_context() call instead of re-registering listeners. Listeners
+         * without a context are in the global context, which is always active. A gamepad has room for 31 contexts.
+         *
+         * @param name The name of the context
+         * @return Context The context with the given name, or the global context if there is no room for another
+         * context (errno is set to ENOSPC)
+         *
+         * @b Example:
+         * @code {.cpp}
+         * gamepad::Context tuning = gamepad::master.context("lift tuning");
+         * gamepad::master.Up.onPress("raiseGain", []() { lift_kP += 0.1; }, {.context = tuning});
+         * // the listener only runs after the context is activated
+         * gamepad::master.push_context(tuning);
+         * @endcode
+         *
+         */
+        Context context(const std::string& name);
+        /**
+         * @brief Activate an input context, on top of any contexts that are already active.
+         *
+         * @param context The context to activate
+         * @param exclusive Whether the contexts below this one on the stack should be deactivated until it is popped
+         * @return true The context was activated
+         * @return false The context was not activated, because the stack is full (errno is set to ENOSPC)
+         *
+         * @b Example:
+         * @code {.cpp}
+         * // only the global context and the auton selector are active until the selector is popped
+         * gamepad::master.push_context(gamepad::master.context("auton selector"), true);
+         * @endcode
+         *
+         */
+        bool push_context(Context context, bool exclusive = false);
+        /**
+         * @brief Deactivate the input context that was activated last.
+         *
+         * @return true The context was deactivated
+         * @return false There are no activated contexts
+         */
+        bool pop_context();
+        /**
+         * @brief Deactivate every input context and then activate the given context.
+         *
+         * @param context The context to activate
+         *
+         * @b Example:
+         * @code {.cpp}
+         * gamepad::master.set_context(gamepad::master.context("drive"));
+         * @endcode
+         *
+         */
+        void set_context(Context context);
+        /**
+         * @brief Whether or not an input context is currently active.
+         *
+         * @param context The context to check
+         * @return true The context is active
+         * @return false The context is not active
+         */
+        bool is_active(Context context) const;
+        /**
+         * @brief Get one of the gamepad's logical actions by name, creating it if it does not exist yet.
+         *
+         * An action is bound to one or more physical inputs (buttons, chords, or joystick thresholds) and is held
+         * while any of them are active. Listeners subscribe to the action instead of a button, so rebinding an action
+         * does not require registering its listeners again. A gamepad has room for 32 actions.
+         *
+         * @param name The name of the action
+         * @return Action The action with the given name, or an invalid action if there is no room for another action
+         * (errno is set to ENOSPC)
+         *
+         * @b Example:
+         * @code {.cpp}
+         * gamepad::Action shoot = gamepad::master.action("shoot");
+         * gamepad::master.bind(shoot, gamepad::Input::button(DIGITAL_R1));
+         * gamepad::master[shoot].onPress("fire", fireCatapult);
+         * @endcode
+         *
+         */
+        Action action(const std::string& name);
+        /**
+         * @brief Bind an action to an additional physical input.
+         *
+         * @param action The action to bind
+         * @param input The input that should activate the action
+         * @return true The input was bound
+         * @return false The action is invalid (errno is set to EINVAL)
+         */
+        bool bind(Action action, Input input);
+        /**
+         * @brief Remove every input bound to an action.
+         *
+         * @param action The action to unbind
+         * @return true At least one input was unbound
+         * @return false The action had no inputs bound to it
+         */
+        bool unbind(Action action);
+        /**
+         * @brief Replace every input bound to an action with a single input.
+         *
+         * @param action The action to rebind
+         * @param input The input that should activate the action
+         * @return true The input was bound
+         * @return false The action is invalid (errno is set to EINVAL)
+         *
+         * @b Example:
+         * @code {.cpp}
+         * // this driver prefers shooting with L1, the listeners on the action are unchanged
+         * gamepad::master.rebind(gamepad::master.action("shoot"), gamepad::Input::button(DIGITAL_L1));
+         * @endcode
+         *
+         */
+        bool rebind(Action action, Input input);
+        /**
+         * @brief Get the state and events of an action, which work just like a button's.
+         *
+         * @param action Which action to return
+         *
+         * @b Example:
+         * @code {.cpp}
+         * gamepad::master[gamepad::master.action("intake_in")].onRelease("stopIntake", []() { intake.brake(); });
+         * @endcode
+         *
+         */
+        const Button& operator[](Action action);
+        /**
+         * @brief Whether or not an action was held as of the last update.
+         *
+         * @param action The action to check
+         * @return true The action is held
+         * @return false The action is not held
+         */
+        bool is_held(Action action) const { return action.is_valid() && (this->held_actions() >> action.index() & 1); }
+        /**
+         * @brief Get which actions were held as of the last update.
+         *
+         * @return uint32_t A bitset where bit i is set if the action with index i is held
+         */
+        uint32_t held_actions() const { return this->action_state.load(std::memory_order_relaxed); }
+        /**
+         * @brief Suspends a @ref Macro for a while, resuming it from this gamepad's update.
+         *
+         * @note the macro is resumed by the first update() after the time is up, so it may sleep for up to one update
+         * period longer
+         *
+         * @param duration How long to suspend the macro for, in ms
+         *
+         * @b Example:
+         * @code {.cpp}
+         * gamepad::Macro partnerMacro() {
+         *   co_await gamepad::partner.sleep_for(250);
+         * }
+         * @endcode
+         *
+         */
+        [[nodiscard]] _impl::SleepAwaiter sleep_for(uint32_t duration) { return {duration, &this->scheduler}; }
         const Button& L1 {m_L1};
         const Button& L2 {m_L2};
         const Button& R1 {m_R1};
@@ -69,13 +514,41 @@ class Gamepad {
         const float& LeftY = m_LeftY;
         const float& RightX = m_RightX;
         const float& RightY = m_RightY;
+        /**
+         * @brief The controller's text screen, which is sent to the controller a little at a time by update()
+         *
+         * @b Example:
+         * @code {.cpp}
+         * gamepad::master.screen.print(0, 0, "Battery: %d%%", pros::battery::get_capacity());
+         * @endcode
+         */
+        Screen screen;
+        /**
+         * @brief The controller's rumble motor, which plays queued patterns one after another
+         *
+         * @b Example:
+         * @code {.cpp}
+         * gamepad::master.rumble.play(".");
+         * @endcode
+         */
+        Rumble rumble;
         /// The master controller, same as @ref gamepad::master
         static Gamepad master;
         /// The partner controller, same as @ref gamepad::partner
         static Gamepad partner;
     private:
         Gamepad(pros::controller_id_e_t id)
-            : controller(id) {}
+            : screen(id),
+              rumble(id),
+              controller(id),
+              controller_source(id) {
+            // macros waiting on a button are resumed by the update of the gamepad that owns it
+            for (int i = pros::E_CONTROLLER_DIGITAL_L1; i <= pros::E_CONTROLLER_DIGITAL_A; ++i) {
+                (this->*Gamepad::button_to_ptr(static_cast<pros::controller_digital_e_t>(i))).scheduler =
+                    &this->scheduler;
+            }
+            this->Fake.scheduler = &this->scheduler;
+        }
 
         Button m_L1 {}, m_L2 {}, m_R1 {}, m_R2 {}, m_Up {}, m_Down {}, m_Left {}, m_Right {}, m_X {}, m_B {}, m_Y {},
             m_A {};
@@ -91,10 +564,172 @@ class Gamepad {
          */
         static std::string unique_name();
         static Button Gamepad::*button_to_ptr(pros::controller_digital_e_t button);
-        void updateButton(pros::controller_digital_e_t button_id);
+        /**
+         * @brief Whether or not the calling task may update the gamepad, only the polling task may update a polled
+         * gamepad
+         */
+        bool can_update() const;
+        /**
+         * @brief Updates the gamepad and publishes a snapshot, regardless of which task is calling it
+         */
+        void run_update();
+        /**
+         * @brief Reads the buttons and joysticks from the controller and updates the state of every button and
+         * action, without firing any events
+         *
+         * @param now The time the gamepad is being sampled at, in ms
+         * @return uint32_t The time the inputs belong to, which is the frame's own timestamp if the input source
+         * keeps its own time (see InputSource::has_own_clock()), and now otherwise
+         */
+        uint32_t sample(uint32_t now);
+        /**
+         * @brief Updates the connection, and reads the battery of the controller if the status period has passed
+         *
+         * @param now The time the gamepad is being sampled at, in ms
+         * @param time The time the inputs belong to, in ms
+         * @param connected Whether or not the input source is connected
+         */
+        void sampleStatus(uint32_t now, uint32_t time, bool connected);
+        /**
+         * @brief Applies the disconnect policy to the inputs, when the controller disconnects
+         *
+         * @param now The current time in ms
+         */
+        void neutralize(uint32_t now);
+        /**
+         * @brief Prepares the inputs to be read again, when the controller reconnects
+         *
+         * @param now The current time in ms
+         */
+        void resume(uint32_t now);
+        /**
+         * @brief Fires the events of the last sample and publishes a snapshot
+         *
+         * @param now The time the gamepad was sampled at, in ms, which paces what is sent to the controller
+         * @param time The time the inputs belong to, as returned by sample(), which the events are timed by
+         */
+        void process(uint32_t now, uint32_t time);
+        /**
+         * @brief Sends a rumble pattern or some text to the controller, if the send period has passed
+         *
+         * @param now The current time in ms
+         */
+        void send(uint32_t now);
+        /**
+         * @brief The body of the polling task
+         */
+        void poll();
+        /**
+         * @brief Resolves which actions are held from the state of the inputs and updates their state
+         *
+         * @param held_buttons Which buttons are held, bit i is set if button DIGITAL_L1 + i is held
+         * @param now The time the gamepad is being sampled at, in ms
+         */
+        void sampleActions(uint16_t held_buttons, uint32_t now);
+        /**
+         * @brief Gets a button without any runtime lookup
+         *
+         * @tparam button_id Which button to return
+         */
+        template <pros::controller_digital_e_t button_id> const Button& get_button() const;
+
+        /**
+         * @brief Runs the functions of a binding table for every event that was fired during the last update
+         */
+        template <typename... Bindings> void dispatch(BindingTable<Bindings...>) const {
+            (this->dispatch_binding<Bindings>(), ...);
+        }
+
+        /**
+         * @brief Runs the function of a single binding as many times as its event was fired during the last update
+         */
+        template <typename Entry> void dispatch_binding() const;
         pros::Controller controller;
+        _impl::ControllerSource controller_source;
+        /// Where the buttons and joysticks are read from
+        std::atomic<InputSource*> source = &this->controller_source;
+        /// The names of the input contexts, the context at index i is represented by bit i + 1
+        std::vector<std::string> context_names {};
+        /// The mask of the active contexts at each level of the context stack
+        std::array<uint32_t, 32> context_stack {};
+        /// How many contexts are on the context stack
+        size_t context_depth = 0;
+        /// The mask of the currently active contexts, the global context is always active
+        std::atomic<uint32_t> active_contexts = Context().mask();
+        _impl::RecursiveMutex context_mutex {};
+
+        struct ActionBinding {
+                Action action;
+                Input input;
+        };
+
+        /// The names of the actions, indexed by the action index
+        std::vector<std::string> action_names {};
+        /// The state and events of each action, indexed by the action index
+        std::vector<std::unique_ptr<Button>> actions {};
+        /// Which inputs activate which actions
+        std::vector<ActionBinding> action_bindings {};
+        /// Which actions were held as of the last update
+        std::atomic<uint32_t> action_state = 0;
+        _impl::RecursiveMutex action_mutex {};
+
+        /// The state as of the last update, published for other tasks
+        _impl::SeqLock<GamepadState> state {};
+        /// The task that updates the gamepad, if it is being polled
+        std::atomic<pros::task_t> poll_task = nullptr;
+        std::atomic<uint32_t> poll_period = 10;
+        std::atomic<bool> polling = false;
+        _impl::RecursiveMutex poll_mutex {};
+
+        /// The minimum time between sending anything to the controller
+        std::atomic<uint32_t> send_period = 50;
+        /// When something was last sent to the controller
+        uint32_t last_send = 0;
+
+        /// The connection and battery as of the last check
+        std::atomic<bool> connected = true;
+        std::atomic<int32_t> capacity = 0;
+        std::atomic<int32_t> level = 0;
+        std::atomic<uint32_t> status_period = 500;
+        std::atomic<int32_t> low_battery_threshold = 20;
+        /// When the connection and battery were last checked, or 0 if they have never been checked
+        uint32_t last_status = 0;
+        bool status_known = false;
+        /// Whether the low battery event has fired, and is waiting for the battery to recover before firing again
+        bool battery_low = false;
+        std::atomic<DisconnectPolicy> disconnect_policy = DISCONNECT_ZERO;
+        /// Whether the inputs were read by the last sample, they are not read while the controller is disconnected
+        bool inputs_sampled = false;
+        /// Which buttons are ignored until they are released, bit i is DIGITAL_L1 + i
+        uint16_t suppressed = 0;
+        /// The time the inputs of the last sample belonged to
+        uint32_t last_time = 0;
+        /// Which status events are waiting to be fired by the next process()
+        bool disconnected_pending = false, reconnected_pending = false, low_battery_pending = false;
+        _impl::EventHandler<std::string> onDisconnectEvent {};
+        _impl::EventHandler<std::string> onReconnectEvent {};
+        _impl::EventHandler<std::string> onLowBatteryEvent {};
+        _impl::Recorder recorder {};
+        /// Resumes the macros waiting on this gamepad, only ever run by the task updating it
+        _impl::Scheduler scheduler {};
 };
 
+template <pros::controller_digital_e_t button_id> inline const Button& Gamepad::get_button() const {
+    constexpr Button Gamepad::*buttons[] {&Gamepad::m_L1, &Gamepad::m_L2, &Gamepad::m_R1, &Gamepad::m_R2,
+                                          &Gamepad::m_Up, &Gamepad::m_Down, &Gamepad::m_Left, &Gamepad::m_Right,
+                                          &Gamepad::m_X, &Gamepad::m_B, &Gamepad::m_Y, &Gamepad::m_A};
+    return this->*buttons[button_id - pros::E_CONTROLLER_DIGITAL_L1];
+}
+
+template <typename Entry> inline void Gamepad::dispatch_binding() const {
+    const Button& button = this->get_button<Entry::button>();
+    const uint32_t times = button.times_fired(Entry::event);
+    for (uint32_t i = 0; i < times; ++i) {
+        if constexpr (Entry::takes_details) Entry::func(button.fired_event(Entry::event, i));
+        else Entry::func();
+    }
+}
+
 inline Gamepad Gamepad::master {pros::E_CONTROLLER_MASTER};
 inline Gamepad Gamepad::partner {pros::E_CONTROLLER_PARTNER};
 /// The master controller
@@ -102,4 +737,24 @@ inline Gamepad& master = Gamepad::master;
 /// The partner controller
 inline Gamepad& partner = Gamepad::partner;
 
+/**
+ * @brief Updates both controllers as a single frame, instead of calling update() on each of them
+ *
+ * Both controllers are sampled first, at the same time, and only then are their events fired: master's listeners run
+ * before partner's, and macros run last. Listeners on either controller therefore see the other controller's state
+ * from the same frame. A controller that is being polled by start_polling() is skipped.
+ *
+ * @b Example:
+ * @code {.cpp}
+ * while (true) {
+ *   gamepad::update_all();
+ *   // partner holds L1 to slow down the drive
+ *   float scale = gamepad::partner.L1 ? 0.5 : 1;
+ *   chassis.arcade(gamepad::master.LeftY * scale, gamepad::master.RightX * scale);
+ *   pros::delay(25);
+ * }
+ * @endcode
+ */
+void update_all();
+
 } // namespace gamepad
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gamepad/event_handler.hpp"
+#include "gamepad/recursive_mutex.hpp"
+#include "pros/rtos.hpp"
+
+namespace gamepad::_impl {
+class Scheduler;
+} // namespace gamepad::_impl
+
+namespace gamepad {
+/**
+ * @brief The return type of a macro, a coroutine that can co_await button events without blocking a task
+ *
+ * A macro starts running as soon as it is called, until its first co_await. After that it is resumed by the
+ * Gamepad::update() of the gamepad it is waiting on, in the task that updates that gamepad, just like a listener. A
+ * macro waiting on a button of the master controller is never resumed by the partner's update, or the other way
+ * around. A macro is never waited for by its caller, and is destroyed once it returns.
+ *
+ * @b Example:
+ * @code {.cpp}
+ *   gamepad::Macro scoreMacro() {
+ *       lift.move(127);
+ *       co_await gamepad::master.R1.released();
+ *       lift.brake();
+ *       co_await gamepad::sleep_for(250);
+ *       claw.set_value(false);
+ *   }
+ *
+ *   gamepad::master.L1.onPress("score", []() { scoreMacro(); });
+ * @endcode
+ */
+class Macro {
+    public:
+        struct promise_type {
+                Macro get_return_object() { return {}; }
+
+                std::suspend_never initial_suspend() noexcept { return {}; }
+
+                std::suspend_never final_suspend() noexcept { return {}; }
+
+                void return_void() {}
+
+                void unhandled_exception() { std::terminate(); }
+
+                /// The scheduler of the gamepad the macro last waited on, which gamepad::sleep_for() sleeps on
+                _impl::Scheduler* scheduler = nullptr;
+        };
+};
+} // namespace gamepad
+
+namespace gamepad::_impl {
+
+/**
+ * @brief Resumes the suspended macros of a gamepad, this is run at the end of every update of that gamepad
+ */
+class Scheduler {
+    public:
+        /**
+         * @brief Resume a macro during the next run
+         *
+         * @param handle The suspended macro
+         */
+        void ready(std::coroutine_handle<> handle) {
+            std::lock_guard lock(this->mutex);
+            this->ready_list.push_back(handle);
+        }
+
+        /**
+         * @brief Resume a macro during the first run at or after a deadline
+         *
+         * @param handle The suspended macro
+         * @param until When to resume the macro, in ms since the program started
+         */
+        void sleep(std::coroutine_handle<> handle, uint32_t until) {
+            std::lock_guard lock(this->mutex);
+            this->sleeping.push_back({until, handle});
+        }
+
+        /**
+         * @brief Set the time of the gamepad's current update, which macros sleep from
+         *
+         * @param time The time the gamepad's inputs belong to, in ms
+         */
+        void set_time(uint32_t time) { this->current_time.store(time, std::memory_order_relaxed); }
+
+        /**
+         * @brief Get the time of the gamepad's current or last update, in ms
+         */
+        uint32_t time() const { return this->current_time.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Resume every macro that is ready or has finished sleeping
+         *
+         * @param now The current time in ms
+         */
+        void run(uint32_t now) {
+            // a macro that updates its own gamepad must not resume macros out from under this run
+            if (this->running) return;
+            {
+                std::lock_guard lock(this->mutex);
+                if (this->ready_list.empty() && this->sleeping.empty()) return;
+                // swapping keeps the capacity of both lists, so a run doesn't allocate once they have grown
+                std::swap(this->ready_list, this->resuming);
+                // compare as signed so deadlines still work when the clock wraps
+                std::erase_if(this->sleeping, [&](const Sleeper& sleeper) {
+                    if (static_cast<int32_t>(now - sleeper.until) < 0) return false;
+                    this->resuming.push_back(sleeper.handle);
+                    return true;
+                });
+            }
+            // macros are resumed without the lock held, so they can suspend themselves again straight away. Anything
+            // they schedule is resumed during the next run
+            this->running = true;
+            for (auto handle : this->resuming) handle.resume();
+            this->resuming.clear();
+            this->running = false;
+        }
+    private:
+        struct Sleeper {
+                uint32_t until;
+                std::coroutine_handle<> handle;
+        };
+
+        std::vector<std::coroutine_handle<>> ready_list {};
+        std::vector<Sleeper> sleeping {};
+        /// The macros being resumed by the current run, only touched by the task updating the gamepad
+        std::vector<std::coroutine_handle<>> resuming {};
+        bool running = false;
+        /// The time of the current or last update, which may be a recording's time rather than pros::millis()
+        std::atomic<uint32_t> current_time = pros::millis();
+        RecursiveMutex mutex {};
+};
+
+/**
+ * @brief Gets the scheduler that a macro sleeps on if it has not waited on a gamepad yet, which is the master's
+ */
+Scheduler& default_scheduler();
+
+/**
+ * @brief Suspends a macro until an event is fired, see Button::pressed()
+ *
+ * @tparam Event the details that the event's listeners are passed
+ */
+template <typename Event> class EventAwaiter {
+    public:
+        EventAwaiter(EventHandler<std::string, const Event&>* handler, Scheduler* scheduler)
+            : handler(handler),
+              scheduler(scheduler) {}
+
+        bool await_ready() const { return this->handler == nullptr; }
+
+        void await_suspend(std::coroutine_handle<Macro::promise_type> handle) {
+            static std::atomic<uint32_t> awaits = 0;
+            handle.promise().scheduler = this->scheduler;
+            // the awaiter lives in the suspended macro's frame, so it outlives its one-shot listener
+            this->handler->add_listener(
+                std::to_string(awaits++) + "_await",
+                [this, handle](const Event& event) {
+                    this->event = event;
+                    this->scheduler->ready(handle);
+                },
+                {.priority = INT_MAX, .max_fires = 1});
+        }
+
+        Event await_resume() const { return this->event; }
+    private:
+        EventHandler<std::string, const Event&>* handler;
+        /// The scheduler of the gamepad the event belongs to
+        Scheduler* scheduler;
+        Event event {};
+};
+
+/**
+ * @brief Suspends a macro for a while, see gamepad::sleep_for()
+ */
+class SleepAwaiter {
+    public:
+        SleepAwaiter(uint32_t duration, Scheduler* scheduler = nullptr)
+            : duration(duration),
+              scheduler(scheduler) {}
+
+        bool await_ready() const { return false; }
+
+        void await_suspend(std::coroutine_handle<Macro::promise_type> handle) const {
+            Scheduler* scheduler = this->scheduler != nullptr ? this->scheduler : handle.promise().scheduler;
+            if (scheduler == nullptr) scheduler = &default_scheduler();
+            handle.promise().scheduler = scheduler;
+            // timed by the gamepad's updates, so a macro sleeps for the same time in a replay as it did when recorded
+            scheduler->sleep(handle, scheduler->time() + this->duration);
+        }
+
+        void await_resume() const {}
+    private:
+        uint32_t duration;
+        /// The scheduler to sleep on, or nullptr for the one the macro last waited on
+        Scheduler* scheduler;
+};
+} // namespace gamepad::_impl
+
+namespace gamepad {
+/**
+ * @brief Suspends a macro for a while, without blocking the task that is running it
+ *
+ * The macro is resumed by the gamepad whose event it last waited on, or by the master controller if it hasn't waited
+ * on one yet. Use Gamepad::sleep_for() to pick the gamepad instead.
+ *
+ * @note the macro is resumed by the first Gamepad::update() after the time is up, so it may sleep for up to one
+ * update period longer
+ *
+ * @param duration How long to suspend the macro for, in ms
+ *
+ * @b Example:
+ * @code {.cpp}
+ *   co_await gamepad::sleep_for(250);
+ * @endcode
+ */
+[[nodiscard]] inline _impl::SleepAwaiter sleep_for(uint32_t duration) { return {duration}; }
+} // namespace gamepad
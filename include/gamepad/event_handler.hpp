@@ -1,56 +1,141 @@
 #pragma once
 
+#include <concepts>
+#include <cstdint>
 #include <mutex>
-#include <functional>
 #include <vector>
 #include <algorithm>
+#include <atomic>
 
-#include "gamepad/recursive_mutex.hpp"
+#include "gamepad/inline_function.hpp"
+#include "gamepad/lock_policy.hpp"
+#include "pros/rtos.hpp"
+
+namespace gamepad {
+/**
+ * @brief A handle to one of a gamepad's input contexts, see Gamepad::context()
+ *
+ * A default constructed context is the global context, which is always active.
+ */
+class Context {
+        friend class Gamepad;
+    public:
+        constexpr Context() = default;
+
+        /**
+         * @brief Gets the bit that represents this context in a gamepad's set of active contexts
+         */
+        constexpr uint32_t mask() const { return this->bit; }
+
+        constexpr bool operator==(const Context& other) const = default;
+    private:
+        constexpr explicit Context(uint32_t bit)
+            : bit(bit) {}
+
+        uint32_t bit = 1;
+};
+
+/**
+ * @brief Optional settings for a listener
+ *
+ * @b Example:
+ * @code {.cpp}
+ *   // run before any listeners with the default priority of 0
+ *   gamepad::master.A.onPress("menuSelect", menuSelect, {.priority = 10});
+ *   // run only the next time B is pressed
+ *   gamepad::master.B.onPress("confirm", confirmAuton, {.max_fires = 1});
+ *   // run at most 3 times, and only in the next 5 seconds
+ *   gamepad::master.X.onPress("tare", tareLift, {.max_fires = 3, .expires_at = pros::millis() + 5000});
+ * @endcode
+ */
+struct ListenerOptions {
+        /// Listeners with a higher priority run first, listeners with the same priority run in the order they were
+        /// added
+        int priority = 0;
+        /// The input context the listener belongs to, the listener only runs while its context is active
+        Context context {};
+        /// How many times the listener runs before it is removed, 0 means the listener is never removed
+        uint32_t max_fires = 0;
+        /// When the listener is removed, in ms since the program started (see pros::millis()), 0 means never
+        uint32_t expires_at = 0;
+};
+} // namespace gamepad
 
 namespace gamepad::_impl {
 
+/**
+ * @brief Whether a listener parameter can be consumed, stopping it from reaching lower priority listeners
+ */
+template <typename T>
+concept Consumable = requires(const T& arg) {
+    { arg.consumed } -> std::convertible_to<bool>;
+};
+
 /**
  * @brief Event handling class with thread safety that supports adding, removing, and running listeners
  *
+ * @tparam Lock the lock that guards the listeners, which MUST be recursive (see GAMEPAD_LOCK_POLICY)
  * @tparam Key the key type for (un)registering listener (this type MUST support operator== and operator!=)
  * @tparam Args the types of the parameters that each listener is passed
  */
-template <typename Key, typename... Args> class EventHandler {
+template <typename Lock, typename Key, typename... Args> class BasicEventHandler {
     public:
-        using Listener = std::function<void(Args...)>;
+        using Listener = InlineFunction<void(Args...)>;
 
         /**
          * @brief Add a listener to the list of listeners
          *
+         * @note a listener added by another listener while this event is firing only starts running the next time the
+         * event is fired
+         *
          * @param key The listener key (this must be a unique key value)
          * @param func The function to run when this event is fired
+         * @param options The priority and other settings of the listener
          * @return true The listener was successfully added
          * @return false The listener was NOT successfully added (there is already a listener with the same key)
          */
-        bool add_listener(Key key, Listener func) {
+        bool add_listener(Key key, Listener func, ListenerOptions options = {}) {
             std::lock_guard lock(mutex);
-            if (std::find(keys.begin(), keys.end(), key) != keys.end()) return false;
-            keys.push_back(key);
-            listeners.push_back(func);
+            if (find(entries, key) != entries.end() || find(pending, key) != pending.end()) return false;
+            if (options.expires_at) ++expiring;
+            Entry entry {std::move(key), std::move(func), options.priority, options.context.mask(), options.max_fires,
+                         options.expires_at};
+            // fire() is walking the listeners, so adding one now would invalidate its iterator
+            if (firing) pending.push_back(std::move(entry));
+            else insert(std::move(entry));
+            count();
             return true;
         }
 
         /**
          * @brief Remove a listener from the list of listeners
          *
+         * @note a listener removed by another listener while this event is firing does not run for the rest of the
+         * current fire, and is erased once it is complete
+         *
          * @param key The listener key (this must be a unique key value)
          * @return true The listener was successfully removed
          * @return false The listener was NOT successfully removed (there is no listener with the same key)
          */
         bool remove_listener(Key key) {
             std::lock_guard lock(mutex);
-            auto i = std::find(keys.begin(), keys.end(), key);
-            if (i != keys.end()) {
-                keys.erase(i);
-                listeners.erase(listeners.begin() + (i - keys.begin()));
+            if (auto i = find(pending, key); i != pending.end()) {
+                if (i->expires_at) --expiring;
+                pending.erase(i);
+                count();
                 return true;
             }
-            return false;
+            auto i = find(entries, key);
+            if (i == entries.end()) return false;
+            // fire() is walking the listeners, so erasing one now would invalidate its iterator
+            if (firing) {
+                i->expired = retiring = true;
+                return true;
+            }
+            if (i->expires_at) --expiring;
+            entries.erase(i);
+            count();
+            return true;
         }
 
         /**
@@ -61,21 +146,135 @@ template <typename Key, typename... Args> class EventHandler {
          */
         bool is_empty() {
             std::lock_guard lock(mutex);
-            return listeners.empty();
+            return entries.empty() && pending.empty();
         }
 
         /**
-         * @brief Runs each listener registered
+         * @brief Gets how contended the lock on the listeners has been
+         *
+         * @return MutexStats The contention statistics, see RecursiveMutex::stats(), which are always 0 for other locks
+         */
+        MutexStats lock_stats() { return mutex.stats(); }
+
+        /**
+         * @brief Runs each listener registered, from highest to lowest priority, until one consumes the event
          *
          * @param args The parameters to pass to each listener
+         * @return true A listener consumed the event
+         * @return false No listener consumed the event
          */
-        void fire(Args... args) {
+        bool fire(Args... args) { return this->fire_in(UINT32_MAX, args...); }
+
+        /**
+         * @brief Runs each listener that belongs to an active context, from highest to lowest priority, until one
+         * consumes the event
+         *
+         * Listeners may add or remove listeners of this event while it is firing, those changes are applied once the
+         * outermost fire is complete.
+         *
+         * @param contexts The mask of the active contexts
+         * @param args The parameters to pass to each listener
+         * @return true A listener consumed the event
+         * @return false No listener consumed the event
+         */
+        bool fire_in(uint32_t contexts, Args... args) {
+            // an event nobody listens to at runtime, such as one only handled by a binding table, skips the lock
+            if (listeners.load(std::memory_order_relaxed) == 0) return false;
             std::lock_guard lock(mutex);
-            for (auto listener : listeners) { listener(args...); }
+            const uint32_t now = expiring ? pros::millis() : 0;
+            bool consumed = false;
+            ++firing;
+            for (auto& entry : entries) {
+                // compare as signed so deadlines still work when the clock wraps
+                if (entry.expires_at && static_cast<int32_t>(now - entry.expires_at) >= 0) {
+                    entry.expired = retiring = true;
+                }
+                if (entry.expired || !(entry.context & contexts)) continue;
+                entry.listener(args...);
+                if (entry.fires_left && --entry.fires_left == 0) entry.expired = retiring = true;
+                if ((is_consumed(args) || ...)) {
+                    consumed = true;
+                    break;
+                }
+            }
+            if (--firing == 0) apply_pending();
+            return consumed;
         }
     private:
-        std::vector<Key> keys {};
-        std::vector<Listener> listeners {};
-        gamepad::_impl::RecursiveMutex mutex {};
+        struct Entry {
+                Key key;
+                Listener listener;
+                int priority;
+                uint32_t context;
+                /// How many more times the listener runs, 0 means unlimited
+                uint32_t fires_left;
+                uint32_t expires_at;
+                /// Whether the listener has been retired, and is waiting to be erased
+                bool expired = false;
+        };
+
+        template <typename T> static bool is_consumed(const T& arg) {
+            if constexpr (Consumable<T>) return arg.consumed;
+            else return false;
+        }
+
+        /**
+         * @brief Finds the listener with a key that has not been retired
+         */
+        static auto find(std::vector<Entry>& list, const Key& key) {
+            return std::find_if(list.begin(), list.end(),
+                                [&](const Entry& entry) { return !entry.expired && entry.key == key; });
+        }
+
+        /**
+         * @brief Inserts a listener after every listener with the same or a higher priority
+         */
+        void insert(Entry entry) {
+            auto position = std::find_if(entries.begin(), entries.end(),
+                                         [&](const Entry& other) { return other.priority < entry.priority; });
+            entries.insert(position, std::move(entry));
+        }
+
+        /**
+         * @brief Applies the changes made while firing, must only be called when no fire is in progress
+         */
+        void apply_pending() {
+            // retire every one-shot, expired, and removed listener in one pass, instead of erasing them one by one
+            if (retiring) {
+                std::erase_if(entries, [&](const Entry& entry) {
+                    if (entry.expired && entry.expires_at) --expiring;
+                    return entry.expired;
+                });
+                retiring = false;
+            }
+            for (auto& entry : pending) insert(std::move(entry));
+            pending.clear();
+            count();
+        }
+
+        /**
+         * @brief Publishes how many listeners there are, must only be called with the lock held
+         */
+        void count() { listeners.store(entries.size() + pending.size(), std::memory_order_relaxed); }
+
+        /// The listeners, sorted from highest to lowest priority
+        std::vector<Entry> entries {};
+        /// The listeners added while firing, which are inserted once the fire is complete
+        std::vector<Entry> pending {};
+        /// How many fires are in progress, more than 1 if a listener fires this event again
+        uint32_t firing = 0;
+        /// Whether any listeners have been retired but not erased yet
+        bool retiring = false;
+        /// How many listeners have a deadline, so the clock is only read when needed
+        uint32_t expiring = 0;
+        /// How many listeners there are, including retired ones that haven't been erased yet, which fire_in() reads
+        /// without the lock
+        std::atomic<uint32_t> listeners = 0;
+        Lock mutex {};
 };
+
+/**
+ * @brief An event handler guarded by the lock chosen with GAMEPAD_LOCK_POLICY
+ */
+template <typename Key, typename... Args> using EventHandler = BasicEventHandler<DefaultLock, Key, Args...>;
 } // namespace gamepad::_impl
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief How many bytes a listener may capture before it no longer fits inline
+ *
+ * The default is large enough for a lambda capturing four pointers, or for a std::function. This can be overriden by
+ * defining it (e.g. adding -DGAMEPAD_LISTENER_CAPACITY=32 to EXTRA_CXXFLAGS), but it MUST be the same value that the
+ * library itself was compiled with.
+ */
+#ifndef GAMEPAD_LISTENER_CAPACITY
+#define GAMEPAD_LISTENER_CAPACITY (4 * sizeof(void*))
+#endif
+
+namespace gamepad::_impl {
+
+template <typename Signature, std::size_t Capacity = GAMEPAD_LISTENER_CAPACITY> class InlineFunction;
+
+/**
+ * @brief A fixed capacity, type erased callable that stores its target inline and never allocates
+ *
+ * Unlike std::function, a callable that does not fit is a compile error rather than a heap allocation. Callables that
+ * cannot take the parameters are called with none, so functions that do not care about the parameters can be used
+ * directly.
+ *
+ * @tparam R the return type of the callable
+ * @tparam Args the types of the parameters that the callable is passed
+ * @tparam Capacity how many bytes are reserved for the callable
+ */
+template <typename R, typename... Args, std::size_t Capacity> class InlineFunction<R(Args...), Capacity> {
+    public:
+        InlineFunction() = default;
+
+        InlineFunction(std::nullptr_t) {}
+
+        /**
+         * @brief Construct a new inline function from a callable
+         *
+         * @param func the callable to store, it must be invocable with either Args... or no parameters
+         */
+        template <typename F>
+            requires(!std::is_same_v<std::remove_cvref_t<F>, InlineFunction> &&
+                     (std::is_invocable_v<std::decay_t<F>&, Args...> || std::is_invocable_v<std::decay_t<F>&>))
+        InlineFunction(F&& func) {
+            using Fn = std::decay_t<F>;
+            static_assert(sizeof(Fn) <= Capacity,
+                          "gamepad: listener captures too much to be stored inline, capture less (e.g. by reference) "
+                          "or increase GAMEPAD_LISTENER_CAPACITY");
+            static_assert(alignof(Fn) <= alignof(std::max_align_t), "gamepad: listener is over-aligned");
+            ::new (static_cast<void*>(storage)) Fn(std::forward<F>(func));
+            invoker = &invoke<Fn>;
+            if constexpr (!std::is_trivially_copyable_v<Fn> || !std::is_trivially_destructible_v<Fn>) {
+                manager = &manage<Fn>;
+            }
+        }
+
+        InlineFunction(const InlineFunction& other) { copy_from(other); }
+
+        InlineFunction(InlineFunction&& other) noexcept { move_from(other); }
+
+        InlineFunction& operator=(const InlineFunction& other) {
+            if (this != &other) {
+                reset();
+                copy_from(other);
+            }
+            return *this;
+        }
+
+        InlineFunction& operator=(InlineFunction&& other) noexcept {
+            if (this != &other) {
+                reset();
+                move_from(other);
+            }
+            return *this;
+        }
+
+        ~InlineFunction() { reset(); }
+
+        /**
+         * @brief Calls the stored callable
+         *
+         * @param args The parameters to pass to the callable
+         * @return R The value returned by the callable
+         */
+        R operator()(Args... args) const { return invoker(storage, std::forward<Args>(args)...); }
+
+        /**
+         * @brief Whether or not a callable is stored
+         */
+        explicit operator bool() const { return invoker != nullptr; }
+    private:
+        enum class Operation { COPY, MOVE, DESTROY };
+
+        template <typename Fn> static R invoke(void* target, Args... args) {
+            Fn& func = *std::launder(static_cast<Fn*>(target));
+            if constexpr (std::is_invocable_v<Fn&, Args...>) {
+                return static_cast<R>(std::invoke(func, std::forward<Args>(args)...));
+            } else {
+                return static_cast<R>(std::invoke(func));
+            }
+        }
+
+        template <typename Fn> static void manage(Operation op, void* dest, void* src) {
+            Fn* source = std::launder(static_cast<Fn*>(src));
+            switch (op) {
+                case Operation::COPY: ::new (dest) Fn(*source); break;
+                case Operation::MOVE:
+                    ::new (dest) Fn(std::move(*source));
+                    source->~Fn();
+                    break;
+                case Operation::DESTROY: source->~Fn(); break;
+            }
+        }
+
+        void copy_from(const InlineFunction& other) {
+            if (other.manager) other.manager(Operation::COPY, storage, other.storage);
+            else std::memcpy(storage, other.storage, Capacity);
+            invoker = other.invoker;
+            manager = other.manager;
+        }
+
+        void move_from(InlineFunction& other) {
+            if (other.manager) other.manager(Operation::MOVE, storage, other.storage);
+            else std::memcpy(storage, other.storage, Capacity);
+            invoker = other.invoker;
+            manager = other.manager;
+            other.invoker = nullptr;
+            other.manager = nullptr;
+        }
+
+        void reset() {
+            if (manager) manager(Operation::DESTROY, nullptr, storage);
+            invoker = nullptr;
+            manager = nullptr;
+        }
+
+        alignas(std::max_align_t) mutable unsigned char storage[Capacity] {};
+        /// Calls the stored callable
+        R (*invoker)(void*, Args...) = nullptr;
+        /// Copies, moves, or destroys the stored callable, null if the callable is trivial
+        void (*manager)(Operation, void*, void*) = nullptr;
+};
+} // namespace gamepad::_impl
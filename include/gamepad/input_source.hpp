@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include "pros/misc.h"
+#include "pros/misc.hpp"
+
+namespace gamepad {
+/**
+ * @brief The inputs of a controller during a single update, as read from an input source or stored in a recording
+ */
+struct InputFrame {
+        /// When the inputs were read, in ms since the program started
+        uint32_t timestamp = 0;
+        /// Which buttons were held, bit i is set if button DIGITAL_L1 + i was held
+        uint16_t buttons = 0;
+        /// The joysticks, in the order LeftX, LeftY, RightX, RightY
+        int8_t axes[4] {};
+
+        bool operator==(const InputFrame& other) const = default;
+};
+
+/**
+ * @brief Where a gamepad reads its buttons and joysticks from, see Gamepad::set_input_source()
+ *
+ * @b Example:
+ * @code {.cpp}
+ *   // hold A for the gamepad, to test the listeners on A without a controller
+ *   class HoldA : public gamepad::InputSource {
+ *       public:
+ *           bool read(uint32_t now, gamepad::InputFrame& frame) override {
+ *               frame = {.timestamp = now, .buttons = 1 << (DIGITAL_A - DIGITAL_L1)};
+ *               return true;
+ *           }
+ *   };
+ * @endcode
+ */
+class InputSource {
+    public:
+        virtual ~InputSource() = default;
+        /**
+         * @brief Read the inputs for an update, this is called once by every update of the gamepad
+         *
+         * @param now The time of the update, in ms
+         * @param frame Where to write the inputs
+         * @return true The inputs were read
+         * @return false The source is disconnected, and the gamepad applies its disconnect policy
+         */
+        virtual bool read(uint32_t now, InputFrame& frame) = 0;
+        /**
+         * @brief Whether the timestamps of the frames are the times the gamepad is updated at
+         *
+         * By default the gamepad is updated at the time update() is called. A source that keeps its own time, such as
+         * a recording, is played back on its own timestamps instead, so the timing of long presses, repeat presses and
+         * macros doesn't depend on when update() happens to run. Such a source must set the timestamp even when it
+         * reads as disconnected, and the gamepad never lets its time go backwards.
+         *
+         * @return true The gamepad is updated at the timestamp of each frame
+         * @return false The gamepad is updated at the time update() is called
+         */
+        virtual bool has_own_clock() const { return false; }
+};
+} // namespace gamepad
+
+namespace gamepad::_impl {
+/**
+ * @brief Reads the inputs from a physical controller, this is the input source a gamepad starts with
+ */
+class ControllerSource : public InputSource {
+    public:
+        ControllerSource(pros::controller_id_e_t id)
+            : controller(id) {}
+
+        bool read(uint32_t now, InputFrame& frame) override;
+    private:
+        pros::Controller controller;
+};
+} // namespace gamepad::_impl
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "gamepad/recursive_mutex.hpp"
+#include "pros/rtos.h"
+
+/**
+ * @brief Which lock guards the listeners of every event
+ *
+ * This is one of NoLock, SpinLock or RecursiveMutex, and defaults to RecursiveMutex. It can be overriden by defining it
+ * (e.g. adding -DGAMEPAD_LOCK_POLICY=SpinLock to EXTRA_CXXFLAGS), but it MUST be the same lock that the library itself
+ * was compiled with.
+ *
+ * NoLock is only safe if every update() call and every listener change happens in the same task. SpinLock is cheaper
+ * than RecursiveMutex when uncontended, but is slower to hand over when it is contended. The "fire" benchmarks in
+ * src/bench/benchmarks.cpp measure what each lock costs per fire, on the brain or with `make host-bench`.
+ */
+#ifndef GAMEPAD_LOCK_POLICY
+#define GAMEPAD_LOCK_POLICY RecursiveMutex
+#endif
+
+namespace gamepad::_impl {
+
+/**
+ * @brief A lock that does nothing, for when listeners are only ever added, removed and fired from a single task
+ */
+class NoLock {
+    public:
+        void lock() {}
+
+        bool try_lock() { return true; }
+
+        void unlock() {}
+
+        MutexStats stats() { return {}; }
+};
+
+/**
+ * @brief A recursive lock that never enters the kernel unless it is contended
+ *
+ * Taking an uncontended SpinLock is a single atomic compare-exchange, instead of a kernel call. The V5 runs user code
+ * on a single core, so spinning while another task holds the lock can never succeed: a contended lock sleeps for 1 ms
+ * at a time instead, which lets the owner run even if it has a lower priority.
+ */
+class SpinLock {
+    public:
+        /**
+         * @brief Locks the lock, blocking until it is acquired
+         *
+         */
+        void lock() {
+            while (!this->try_lock()) pros::c::delay(1);
+        }
+
+        /**
+         * @brief Attempts to lock the lock without blocking the current task
+         *
+         * @return true The lock was successfully acquired
+         * @return false The lock was not successfully acquired
+         */
+        bool try_lock() {
+            const pros::task_t self = pros::c::task_get_current();
+            // only the owner can see itself here, so the depth is never touched by two tasks at once
+            if (this->owner.load(std::memory_order_relaxed) == self) {
+                ++this->depth;
+                return true;
+            }
+            pros::task_t expected = nullptr;
+            if (!this->owner.compare_exchange_strong(expected, self, std::memory_order_acquire)) return false;
+            this->depth = 1;
+            return true;
+        }
+
+        /**
+         * @brief Unlocks the lock, it is only released once it has been unlocked as many times as it was locked
+         *
+         */
+        void unlock() {
+            if (--this->depth == 0) this->owner.store(nullptr, std::memory_order_release);
+        }
+
+        MutexStats stats() { return {}; }
+    private:
+        std::atomic<pros::task_t> owner = nullptr;
+        uint32_t depth = 0;
+};
+
+/// The lock that guards the listeners of every event, see GAMEPAD_LOCK_POLICY
+using DefaultLock = GAMEPAD_LOCK_POLICY;
+} // namespace gamepad::_impl
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gamepad/controller.hpp"
+#include "gamepad/inline_function.hpp"
+#include "gamepad/recursive_mutex.hpp"
+
+namespace gamepad {
+/**
+ * @brief A single line of a @ref Menu, which shows a label on the left and a value on the right
+ */
+class Widget {
+        friend class Menu;
+    public:
+        Widget(std::string label)
+            : label(std::move(label)) {}
+
+        virtual ~Widget() = default;
+    protected:
+        /**
+         * @brief Writes the value of the widget
+         *
+         * @param out Where to write the value
+         * @param size How many characters fit in out, including the '\0'
+         */
+        virtual void format(char* out, size_t size) const = 0;
+        /**
+         * @brief Changes the value of the widget when left or right is pressed
+         *
+         * @param direction -1 for left, 1 for right
+         * @return true The value changed
+         * @return false The value did not change
+         */
+        virtual bool adjust(int direction) = 0;
+
+        /**
+         * @brief Changes the value of the widget when A is pressed
+         *
+         * @return true The value changed
+         * @return false The value did not change
+         */
+        virtual bool select() { return this->adjust(1); }
+
+        std::string label;
+};
+
+/**
+ * @brief A widget that switches between on and off
+ */
+class Toggle : public Widget {
+    public:
+        /**
+         * @brief Construct a new toggle
+         *
+         * @param label The text on the left of the line
+         * @param value Whether the toggle starts on
+         * @param on_change A function to run with the new value whenever it is changed from the menu
+         */
+        Toggle(std::string label, bool value = false, _impl::InlineFunction<void(bool)> on_change = {})
+            : Widget(std::move(label)),
+              value(value),
+              on_change(std::move(on_change)) {}
+
+        /**
+         * @brief Whether or not the toggle is on
+         */
+        bool get() const { return this->value; }
+    protected:
+        void format(char* out, size_t size) const override;
+        bool adjust(int direction) override;
+    private:
+        bool value;
+        _impl::InlineFunction<void(bool)> on_change;
+};
+
+/**
+ * @brief A widget that picks a number from a range, in steps
+ */
+class Slider : public Widget {
+    public:
+        /**
+         * @brief Construct a new slider
+         *
+         * @param label The text on the left of the line
+         * @param min The lowest value
+         * @param max The highest value
+         * @param step How much left and right change the value by
+         * @param value The starting value
+         * @param on_change A function to run with the new value whenever it is changed from the menu
+         */
+        Slider(std::string label, float min, float max, float step, float value,
+               _impl::InlineFunction<void(float)> on_change = {})
+            : Widget(std::move(label)),
+              min(min),
+              max(max),
+              step(step),
+              value(value),
+              on_change(std::move(on_change)) {}
+
+        /**
+         * @brief Gets the value of the slider
+         */
+        float get() const { return this->value; }
+    protected:
+        void format(char* out, size_t size) const override;
+        bool adjust(int direction) override;
+    private:
+        float min;
+        float max;
+        float step;
+        float value;
+        _impl::InlineFunction<void(float)> on_change;
+};
+
+/**
+ * @brief A widget that picks one of a list of options, such as an autonomous routine
+ */
+class List : public Widget {
+    public:
+        /**
+         * @brief Construct a new list
+         *
+         * @param label The text on the left of the line
+         * @param options The options to pick from
+         * @param index Which option is picked to start with
+         * @param on_change A function to run with the index of the new option whenever it is changed from the menu
+         */
+        List(std::string label, std::vector<std::string> options, size_t index = 0,
+             _impl::InlineFunction<void(size_t)> on_change = {})
+            : Widget(std::move(label)),
+              options(std::move(options)),
+              index(index),
+              on_change(std::move(on_change)) {}
+
+        /**
+         * @brief Gets the index of the picked option
+         */
+        size_t get() const { return this->index; }
+
+        /**
+         * @brief Gets the picked option, this MUST NOT be called on a list without any options
+         */
+        const std::string& option() const { return this->options[this->index]; }
+    protected:
+        void format(char* out, size_t size) const override;
+        bool adjust(int direction) override;
+    private:
+        std::vector<std::string> options;
+        size_t index;
+        _impl::InlineFunction<void(size_t)> on_change;
+};
+
+/**
+ * @brief A list of widgets on a controller's screen, navigated with the controller's buttons
+ *
+ * While the menu is open, Up and Down move the cursor, Left and Right change the widget under the cursor (holding them
+ * repeats), A selects it, and B closes the menu. The menu runs in its own input context, pushed exclusively, so
+ * listeners in other contexts do not see these presses while it is open. The menu is only redrawn when something
+ * changes, and the screen only sends the characters that changed.
+ *
+ * @b Example:
+ * @code {.cpp}
+ *   gamepad::Menu selector(gamepad::master, "selector");
+ *   auto& auton = selector.add<gamepad::List>("Auton", std::vector<std::string> {"Left", "Right", "Skills"});
+ *   auto& kP = selector.add<gamepad::Slider>("kP", 0, 5, 0.05, 1.2);
+ *   selector.open();
+ * @endcode
+ */
+class Menu {
+    public:
+        /**
+         * @brief Construct a new menu, which starts closed
+         *
+         * @param gamepad The gamepad to show the menu on, and read buttons from
+         * @param name The name of the menu, this must be unique
+         */
+        Menu(Gamepad& gamepad, std::string name);
+        Menu(const Menu&) = delete;
+        Menu& operator=(const Menu&) = delete;
+        ~Menu();
+
+        /**
+         * @brief Add a widget to the bottom of the menu
+         *
+         * @tparam W The type of the widget
+         * @param args The arguments to construct the widget with
+         * @return W& The widget, which lives as long as the menu
+         */
+        template <typename W, typename... Args> W& add(Args&&... args) {
+            auto widget = std::make_unique<W>(std::forward<Args>(args)...);
+            W& ref = *widget;
+            std::lock_guard lock(this->mutex);
+            this->widgets.push_back(std::move(widget));
+            this->render();
+            return ref;
+        }
+
+        /**
+         * @brief Show the menu and start reading buttons
+         *
+         * @return true The menu was opened
+         * @return false The menu is already open, or its context could not be pushed
+         */
+        bool open();
+        /**
+         * @brief Stop reading buttons and clear the screen, this is also done by pressing B
+         *
+         * @note the menu's context is popped, so this should only be called while it is on top of the context stack
+         *
+         * @return true The menu was closed
+         * @return false The menu is not open
+         */
+        bool close();
+        /**
+         * @brief Whether or not the menu is open
+         */
+        bool is_open() const { return this->opened; }
+    private:
+        void move(int direction);
+        void adjust(int direction);
+        void select();
+        /**
+         * @brief Draws the visible widgets into the screen's back buffer, if the menu is open
+         */
+        void render();
+        /**
+         * @brief Gets the name of one of the menu's internal listeners
+         */
+        std::string listener_name(const char* button) const;
+
+        /// A button that moves the cursor or changes a widget, and repeats while held
+        struct Navigation {
+                const Button* button;
+                const char* key;
+                void (Menu::*action)(int);
+                int direction;
+        };
+
+        /**
+         * @brief Gets the buttons that move the cursor or change a widget
+         */
+        std::array<Navigation, 4> navigation() const;
+
+        Gamepad& gamepad;
+        std::string name;
+        Context context;
+        std::vector<std::unique_ptr<Widget>> widgets {};
+        /// Which widget is under the cursor
+        size_t cursor = 0;
+        /// Which widget is on the top line of the screen
+        size_t top = 0;
+        bool opened = false;
+        _impl::RecursiveMutex mutex {};
+};
+} // namespace gamepad
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+#include "gamepad/inline_function.hpp"
+#include "gamepad/input_source.hpp"
+#include "gamepad/recursive_mutex.hpp"
+#include "gamepad/state.hpp"
+#include "pros/rtos.h"
+
+namespace gamepad::_impl {
+/**
+ * @brief Compresses input frames into the recording format
+ *
+ * A recording starts with the magic bytes "GPR1" and the timestamp it started at (4 bytes, little endian), followed
+ * by one record per frame that changed:
+ *
+ * - A tag byte below 0x80 says what changed since the previous frame. Bit 0 is set if the buttons changed, bits 1 to 4
+ *   if LeftX, LeftY, RightX or RightY changed, and bit 5 if the time since the previous frame changed. It is followed
+ *   by the new time since the previous frame (a LEB128 varint), the new buttons (2 bytes, little endian), and the new
+ *   value of each changed joystick (1 byte each), in that order, for whichever of them changed.
+ * - A tag byte of 0x80 + n repeats the previous frame n + 1 more times, with the same time between each frame.
+ *
+ * The joysticks rarely all move at once, and an untouched controller costs a byte every 128 frames.
+ */
+class FrameEncoder {
+    public:
+        /// The size of the header at the start of a recording
+        static constexpr size_t HEADER_SIZE = 8;
+        /// The most bytes that encoding a single frame can produce
+        static constexpr size_t MAX_ENCODED_SIZE = 1 + 1 + 5 + 2 + 4;
+
+        /**
+         * @brief Start a new recording
+         *
+         * @param start The timestamp the recording starts at, in ms
+         * @param out Where to write the header, at least HEADER_SIZE bytes
+         * @return size_t The number of bytes written
+         */
+        size_t begin(uint32_t start, uint8_t* out);
+        /**
+         * @brief Encode the next frame of the recording
+         *
+         * @param frame The frame, its timestamp must not be before the previous frame's
+         * @param out Where to write the encoded frame, at least MAX_ENCODED_SIZE bytes
+         * @return size_t The number of bytes written, which is 0 if the frame was added to a pending repeat
+         */
+        size_t encode(const InputFrame& frame, uint8_t* out);
+        /**
+         * @brief Write out the pending repeat, if there is one, this must be done at the end of a recording
+         *
+         * @param out Where to write the repeat, at least 1 byte
+         * @return size_t The number of bytes written
+         */
+        size_t finish(uint8_t* out);
+    private:
+        InputFrame last {};
+        uint32_t last_interval = 0;
+        /// How many frames since the last record were the same as it
+        uint32_t repeats = 0;
+        bool started = false;
+};
+
+/**
+ * @brief Reads input frames back out of a recording, see FrameEncoder for the format
+ *
+ * The recording is read a block at a time, so it never has to fit in RAM.
+ */
+class FrameDecoder {
+    public:
+        /// Copies up to max bytes of the recording to out and returns how many it copied, 0 once the recording ends
+        using Source = InlineFunction<size_t(uint8_t* out, size_t max)>;
+
+        /**
+         * @brief Start reading a recording
+         *
+         * @param source Where to read the recording from, starting at the start of the recording
+         * @return true The recording was started
+         * @return false The source is not a recording (errno is set to EINVAL)
+         */
+        bool begin(Source source);
+        /**
+         * @brief Read the next frame of the recording
+         *
+         * @param frame Where to write the frame
+         * @return true The frame was read
+         * @return false The recording has ended, or starts with a repeat of a frame it never had
+         */
+        bool next(InputFrame& frame);
+    private:
+        /**
+         * @brief Reads the next byte of the recording, reading another block once the last one is used up
+         *
+         * @return int The byte, or EOF
+         */
+        int get();
+
+        Source source {};
+        uint8_t block[512];
+        size_t position = 0, size = 0;
+        InputFrame last {};
+        uint32_t last_interval = 0;
+        /// How many more times the last frame repeats
+        uint32_t repeats = 0;
+        /// Whether a whole frame has been read yet, before which there is nothing to repeat
+        bool started = false;
+};
+
+/**
+ * @brief A byte queue for exactly one task writing to it and one other task reading from it, without any locks
+ */
+class ByteRing {
+    public:
+        /**
+         * @brief Empty the queue and set its capacity, which must not be done while either task is using it
+         *
+         * @param capacity How many bytes the queue can hold
+         */
+        void reset(size_t capacity);
+        /**
+         * @brief Add some bytes to the end of the queue, only from the writing task
+         *
+         * @return true The bytes were added
+         * @return false There is not enough room for all of the bytes, so none of them were added
+         */
+        bool push(const uint8_t* bytes, size_t size);
+        /**
+         * @brief Remove bytes from the front of the queue, only from the reading task
+         *
+         * @param out Where to copy the bytes
+         * @param max The most bytes to remove
+         * @return size_t The number of bytes removed
+         */
+        size_t pop(uint8_t* out, size_t max);
+        /// How many bytes are in the queue
+        size_t size() const { return this->head.load(std::memory_order_acquire) - this->tail.load(); }
+        /// How many more bytes the queue can hold
+        size_t room() const { return this->capacity - this->size(); }
+    private:
+        std::unique_ptr<uint8_t[]> data {};
+        size_t capacity = 0;
+        /// How many bytes have ever been pushed and popped, the difference is how many are in the queue
+        std::atomic<size_t> head = 0, tail = 0;
+};
+
+/**
+ * @brief Records the inputs of a gamepad to a file, see Gamepad::start_recording()
+ *
+ * Frames are encoded by the task updating the gamepad into a buffer in RAM, and a low priority task writes the buffer
+ * to the file in blocks, so the update never waits on the SD card.
+ */
+class Recorder {
+    public:
+        /// How much is written to the file at once
+        static constexpr size_t BLOCK_SIZE = 512;
+
+        /**
+         * @brief Start recording to a file, replacing it if it already exists
+         *
+         * @param path The path of the file
+         * @param now The time the recording starts at, in ms
+         * @param buffer_size How many bytes can wait in RAM to be written to the file
+         * @return true Recording started
+         * @return false A recording is still being written (errno is set to EBUSY), the buffer is smaller than a block
+         * (errno is set to EINVAL), or the file could not be opened or the writing task could not be created (errno is
+         * set by fopen or pros::Task::create)
+         */
+        bool start(const char* path, uint32_t now, size_t buffer_size);
+        /**
+         * @brief Stop recording, the rest of the buffer is written to the file in the background
+         */
+        void stop();
+        /**
+         * @brief Whether or not frames are being recorded, or are still being written to the file
+         */
+        bool is_recording() const { return this->active || this->file.load() != nullptr; }
+        /**
+         * @brief Add a frame to the recording, only from the task updating the gamepad
+         *
+         * @param state The state of the gamepad after the update
+         */
+        void record(const GamepadState& state);
+    private:
+        /**
+         * @brief Appends bytes to the buffer, stopping the recording if the file can't keep up
+         */
+        void push(const uint8_t* bytes, size_t size);
+        /**
+         * @brief The body of the writing task
+         */
+        void write();
+
+        FrameEncoder encoder {};
+        ByteRing ring {};
+        /// The file being written to, which is closed by the writing task once the buffer is empty after stopping
+        std::atomic<FILE*> file = nullptr;
+        std::atomic<bool> active = false;
+        std::atomic<bool> stopping = false;
+        pros::task_t task = nullptr;
+        RecursiveMutex mutex {};
+};
+} // namespace gamepad::_impl
+
+namespace gamepad {
+/**
+ * @brief Plays a recording back as the inputs of a gamepad, see Gamepad::start_recording() and
+ * Gamepad::set_input_source()
+ *
+ * Every update of the gamepad reads the next frame of the recording, and is timed by when that frame was recorded
+ * instead of by when update() is called, so the gamepad fires exactly the events it fired while it was recorded, at the
+ * same times relative to the start of the replay. A low priority task reads the recording from the file ahead of the
+ * replay, so the update never waits on the SD card unless the card falls behind. Once the recording ends, the replay
+ * reads as a disconnected controller, so the gamepad's disconnect policy (see Gamepad::set_disconnect_policy()) takes
+ * over instead of the replay releasing everything as if the driver let go.
+ *
+ * @b Example:
+ * @code {.cpp}
+ *   void autonomous() {
+ *     gamepad::Replay replay;
+ *     if (!replay.open("/usd/skills.gpr")) return;
+ *     gamepad::master.set_input_source(&replay);
+ *     while (!replay.is_finished()) {
+ *       gamepad::master.update();
+ *       chassis.arcade(gamepad::master.LeftY, gamepad::master.RightX);
+ *       pros::delay(10);
+ *     }
+ *     gamepad::master.set_input_source(nullptr);
+ *   }
+ * @endcode
+ */
+class Replay : public InputSource {
+    public:
+        /// How much is read from the file at once
+        static constexpr size_t BLOCK_SIZE = 512;
+
+        Replay() = default;
+        Replay(const Replay&) = delete;
+        Replay& operator=(const Replay&) = delete;
+        ~Replay();
+
+        /**
+         * @brief Open a recording to play back from the start, closing the one that was open
+         *
+         * @param path The path of the recording
+         * @param buffer_size How many bytes of the recording are read ahead of the replay, at least 512
+         * @return true The recording was opened
+         * @return false The buffer is too small (errno is set to EINVAL), the file could not be opened (errno is set
+         * by fopen), the reading task could not be created (errno is set by pros::Task::create), or the file is not a
+         * recording (errno is set to EINVAL)
+         */
+        bool open(const char* path, size_t buffer_size = 4096);
+        /**
+         * @brief Close the recording, the gamepad then reads it as a disconnected controller
+         */
+        void close();
+        /**
+         * @brief Whether or not every frame of the recording has been played
+         *
+         * @return true The recording has ended, or none is open
+         * @return false There are frames left to play
+         */
+        bool is_finished() const { return this->finished; }
+
+        bool read(uint32_t now, InputFrame& frame) override;
+
+        bool has_own_clock() const override { return true; }
+    private:
+        /**
+         * @brief Takes the next bytes read ahead by the reading task, waiting for it only if it has fallen behind
+         */
+        size_t fill(uint8_t* out, size_t max);
+        /**
+         * @brief The body of the reading task, which exits once the recording is closed
+         */
+        void prefetch();
+
+        _impl::FrameDecoder decoder {};
+        _impl::ByteRing ring {};
+        /// The open recording, only read by the reading task, and only closed while holding file_mutex
+        FILE* file = nullptr;
+        _impl::RecursiveMutex file_mutex {};
+        pros::task_t task = nullptr;
+        /// Whether the reading task has reached the end of the file
+        std::atomic<bool> ended = false;
+        /// Whether the reading task has exited
+        std::atomic<bool> task_done = true;
+        /// The task to notify when the reading task reads a block or exits
+        std::atomic<pros::task_t> waiter = nullptr;
+        std::atomic<bool> finished = true;
+        /// Whether the first frame has been played, which the rest of the recording is timed from
+        bool started = false;
+        /// How far the recording's timestamps are moved, so the first frame plays when it is read
+        uint32_t shift = 0;
+        _impl::RecursiveMutex mutex {};
+};
+} // namespace gamepad
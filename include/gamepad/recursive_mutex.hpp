@@ -1,8 +1,31 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
 #include "pros/apix.h"
 #include "pros/rtos.h"
 
+namespace gamepad {
+/**
+ * @brief How contended a mutex has been, see Button::lock_stats()
+ *
+ * @note these are only counted if the library is compiled with GAMEPAD_MUTEX_STATS defined, otherwise they are
+ * always 0. Only the library's own sources look at the define, so code that uses the library doesn't need it
+ */
+struct MutexStats {
+        /// How many times the mutex was acquired
+        uint32_t acquisitions = 0;
+        /// How many of those times the mutex was held by another task, and had to be waited for
+        uint32_t contentions = 0;
+        /// How long was spent waiting for the mutex in total, in microseconds
+        uint64_t total_wait = 0;
+        /// The longest single wait for the mutex, in microseconds
+        uint32_t max_wait = 0;
+};
+} // namespace gamepad
+
 namespace gamepad::_impl {
 
 class RecursiveMutex {
@@ -10,9 +33,9 @@ class RecursiveMutex {
         /**
          * @brief Construct a new recursive mutex
          *
+         * @note if the kernel can't create the mutex, the program is aborted instead of running without it
          */
-        RecursiveMutex()
-            : mutex(pros::c::mutex_recursive_create()) {}
+        RecursiveMutex();
 
         /**
          * @brief Locks the recursive mutex, optionally bailing out after a timeout
@@ -21,14 +44,25 @@ class RecursiveMutex {
          * @return true The mutex was successfully acquired
          * @return false The mutex was not successfully acquired
          */
-        bool take(std::uint32_t timeout = TIMEOUT_MAX) { return pros::c::mutex_recursive_take(mutex, timeout); }
+        bool take(std::uint32_t timeout = TIMEOUT_MAX);
 
         /**
-         * @brief Locks the mutex, waiting indefinetely until the mutex is acquired
+         * @brief Locks the mutex, blocking until the mutex is acquired
          *
+         * @note the program is aborted if the kernel fails to take the mutex, since the caller would otherwise run
+         * its critical section unprotected
+         */
+        void lock();
+
+        /**
+         * @brief Attempts to lock the mutex, bailing out after a timeout
+         *
+         * @param timeout How long to wait for the mutex
+         * @return true The mutex was successfully acquired
+         * @return false The mutex was not successfully acquired
          */
-        void lock() {
-            while (!this->take()) pros::delay(2);
+        template <typename Rep, typename Period> bool try_lock_for(std::chrono::duration<Rep, Period> timeout) {
+            return this->take(std::chrono::ceil<std::chrono::milliseconds>(timeout).count());
         }
 
         /**
@@ -53,12 +87,27 @@ class RecursiveMutex {
          */
         void unlock() { this->give(); }
 
+        /**
+         * @brief Gets how contended the mutex has been since it was created or since reset_stats()
+         *
+         * @return MutexStats The contention statistics, which are always 0 unless GAMEPAD_MUTEX_STATS is defined
+         */
+        MutexStats stats();
+
+        /**
+         * @brief Resets the contention statistics to 0
+         *
+         */
+        void reset_stats();
+
         /**
          * @brief Destroy the recursive mutex and free any allocated memory
          */
         ~RecursiveMutex() { pros::c::mutex_delete(mutex); }
     private:
         pros::mutex_t mutex;
+        /// Always part of the layout, so code built with and without GAMEPAD_MUTEX_STATS can share a mutex
+        MutexStats counters {};
 };
 
-} // namespace gamepad::_impl
\ No newline at end of file
+} // namespace gamepad::_impl
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "gamepad/recursive_mutex.hpp"
+#include "pros/misc.h"
+
+namespace gamepad {
+/**
+ * @brief The rumble motor of a controller, see Gamepad::rumble
+ *
+ * Patterns are queued instead of being sent straight away, since a pattern sent to the controller cuts off the one it
+ * is playing. The gamepad sends the highest priority pattern once the previous one has finished, sharing the link to
+ * the controller with the screen.
+ */
+class Rumble {
+        friend class Gamepad;
+    public:
+        /// The longest pattern the controller supports
+        static constexpr size_t MAX_PATTERN_LENGTH = 8;
+        /// How many patterns can be waiting to play at once
+        static constexpr size_t MAX_QUEUED = 8;
+
+        /**
+         * @brief Queue a pattern to play once the patterns before it have finished
+         *
+         * If the same pattern is already waiting to play, the two are combined into one with the higher of their
+         * priorities.
+         *
+         * @param pattern Up to 8 of '.' (a short rumble), '-' (a long rumble) and ' ' (a pause)
+         * @param priority Patterns with a higher priority play first, patterns with the same priority play in the
+         * order they were queued
+         * @return true The pattern was queued
+         * @return false The pattern is invalid (errno is set to EINVAL) or the queue is full (errno is set to ENOSPC)
+         *
+         * @b Example:
+         * @code {.cpp}
+         *   // warn the driver that endgame is starting, even if other alerts are waiting
+         *   gamepad::master.rumble.play("- - -", 10);
+         * @endcode
+         */
+        bool play(std::string_view pattern, int priority = 0);
+        /**
+         * @brief Drop every pattern that is waiting to play, the pattern that is playing is not stopped
+         *
+         */
+        void clear();
+        /**
+         * @brief Whether or not there are no patterns playing or waiting to play
+         *
+         * @return true Nothing is playing or waiting to play
+         * @return false A pattern is playing or waiting to play
+         */
+        bool is_idle();
+    private:
+        Rumble(pros::controller_id_e_t id)
+            : id(id) {}
+
+        /**
+         * @brief Sends the next pattern to the controller, if the previous one has finished
+         *
+         * @param now The current time in ms
+         * @return true A pattern was sent, or failed to send
+         * @return false Nothing was sent
+         */
+        bool send(uint32_t now);
+        /**
+         * @brief Estimates how long a pattern takes to play
+         *
+         * @param pattern The pattern
+         * @return uint32_t The estimated time in ms
+         */
+        static uint32_t duration(std::string_view pattern);
+
+        struct Pattern {
+                /// The pattern, terminated with a '\0'
+                std::array<char, MAX_PATTERN_LENGTH + 1> text;
+                int priority;
+        };
+
+        pros::controller_id_e_t id;
+        /// The patterns waiting to play, sorted from highest to lowest priority
+        std::vector<Pattern> queue {};
+        /// When the pattern that is playing finishes, in ms
+        uint32_t busy_until = 0;
+        _impl::RecursiveMutex mutex {};
+};
+} // namespace gamepad
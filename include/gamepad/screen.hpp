@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "gamepad/recursive_mutex.hpp"
+#include "pros/misc.h"
+
+namespace gamepad {
+/**
+ * @brief The text screen of a controller, see Gamepad::screen
+ *
+ * Text is written to a back buffer, which is never blocked on and never dropped. Every update, the gamepad sends at
+ * most one changed span of the back buffer to the controller, since the controller ignores text sent more often than
+ * every 50 ms (see Gamepad::set_send_period()). Only characters that differ from what the controller is already showing
+ * are sent.
+ */
+class Screen {
+        friend class Gamepad;
+    public:
+        /// How many lines of text the screen has
+        static constexpr uint8_t LINES = 3;
+        /// How many characters fit on each line
+        static constexpr uint8_t COLUMNS = 15;
+
+        /**
+         * @brief Write text to the screen, overwriting whatever was there, text past the end of the line is cut off
+         *
+         * @param line Which line to write to [0-2]
+         * @param column Which column to start writing at [0-14]
+         * @param text The text to write
+         * @return true The text was written
+         * @return false The line or column is out of range (errno is set to EINVAL)
+         *
+         * @b Example:
+         * @code {.cpp}
+         *   gamepad::master.screen.set_text(0, 0, "Auton: Left");
+         * @endcode
+         */
+        bool set_text(uint8_t line, uint8_t column, std::string_view text);
+        /**
+         * @brief Write formatted text to the screen, same as set_text() but with a printf format string
+         *
+         * @param line Which line to write to [0-2]
+         * @param column Which column to start writing at [0-14]
+         * @param fmt The format string
+         * @return true The text was written
+         * @return false The line or column is out of range (errno is set to EINVAL)
+         *
+         * @b Example:
+         * @code {.cpp}
+         *   gamepad::master.screen.print(1, 0, "Temp: %3.0fC", lift.get_temperature());
+         * @endcode
+         */
+        bool print(uint8_t line, uint8_t column, const char* fmt, ...) __attribute__((format(printf, 4, 5)));
+        /**
+         * @brief Replace a whole line of the screen, padding it with spaces
+         *
+         * @param line Which line to replace [0-2]
+         * @param text The new text of the line
+         * @return true The line was replaced
+         * @return false The line is out of range (errno is set to EINVAL)
+         */
+        bool set_line(uint8_t line, std::string_view text);
+        /**
+         * @brief Clear a line of the screen
+         *
+         * @param line Which line to clear [0-2]
+         * @return true The line was cleared
+         * @return false The line is out of range (errno is set to EINVAL)
+         */
+        bool clear_line(uint8_t line);
+        /**
+         * @brief Clear the screen, and send every line again even if it has not changed
+         *
+         * This also clears anything that was written to the controller without going through the screen.
+         */
+        void clear();
+        /**
+         * @brief Whether or not the controller is showing everything in the back buffer
+         *
+         * @return true Every change has been sent
+         * @return false Some changes have not been sent yet
+         */
+        bool is_synced();
+    private:
+        Screen(pros::controller_id_e_t id)
+            : id(id) {
+            for (auto& line : this->buffer) line.fill(' ');
+            this->sent = this->buffer;
+        }
+
+        /**
+         * @brief Sends the next changed span to the controller
+         *
+         * @return true A span was sent, or failed to send
+         * @return false Nothing has changed
+         */
+        bool send();
+        using Line = std::array<char, COLUMNS>;
+
+        pros::controller_id_e_t id;
+        /// What should be shown on each line
+        std::array<Line, LINES> buffer {};
+        /// What the controller is showing on each line, a '\0' means the character is unknown
+        std::array<Line, LINES> sent {};
+        /// Which line is checked first for changes, so one busy line can't starve the others
+        uint8_t next_line = 0;
+        _impl::RecursiveMutex mutex {};
+};
+} // namespace gamepad
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace gamepad::_impl {
+
+/**
+ * @brief Publishes a value from a single writer to any number of readers, without any locks
+ *
+ * This is a latched sequence lock: the value is kept twice, and the sequence counter tells readers which copy is not
+ * being written to right now. A reader therefore never waits for a writer that has been preempted part way through a
+ * write, it only retries if a whole new value was published while it was reading.
+ *
+ * @tparam T the type of the value, which must be trivially copyable
+ */
+template <typename T> class SeqLock {
+        static_assert(std::is_trivially_copyable_v<T>, "gamepad: a SeqLock value must be trivially copyable");
+    public:
+        /**
+         * @brief Publish a new value, this must only ever be called from one task at a time
+         *
+         * @param value The value to publish
+         */
+        void store(const T& value) {
+            Words words {};
+            std::memcpy(words.data(), &value, sizeof(T));
+            const uint32_t start = sequence.load(std::memory_order_relaxed);
+            // readers move to copy 1 while copy 0 is written, then back to copy 0 while copy 1 is written
+            for (uint32_t i = 0; i < 2; ++i) {
+                // the previous copy must be complete before readers are sent to it, and readers must be sent away from
+                // this copy before it is written
+                sequence.store(start + i + 1, std::memory_order_release);
+                std::atomic_thread_fence(std::memory_order_release);
+                for (size_t j = 0; j < WORDS; ++j) copies[i][j].store(words[j], std::memory_order_relaxed);
+            }
+            // readers are only sent to copy 1 by the next store, which releases it first
+        }
+
+        /**
+         * @brief Get a consistent copy of the last published value, this is safe to call from any task
+         *
+         * @return T The last published value
+         */
+        T load() const {
+            Words words {};
+            uint32_t before = 0;
+            do {
+                before = sequence.load(std::memory_order_acquire);
+                const auto& copy = copies[before & 1];
+                for (size_t j = 0; j < WORDS; ++j) words[j] = copy[j].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+            } while (sequence.load(std::memory_order_relaxed) != before);
+            T value;
+            std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+            return value;
+        }
+    private:
+        static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+        using Words = std::array<uint32_t, WORDS>;
+
+        std::atomic<uint32_t> sequence = 0;
+        std::array<std::array<std::atomic<uint32_t>, WORDS>, 2> copies {};
+};
+} // namespace gamepad::_impl
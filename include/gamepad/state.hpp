@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+#include "pros/misc.h"
+
+namespace gamepad {
+/**
+ * @brief A copy of the timing of a single button, see GamepadState
+ */
+struct ButtonState {
+        /// How long the button has been held, in ms
+        uint32_t time_held = 0;
+        /// How long the button has been released, in ms
+        uint32_t time_released = 0;
+        /// How many times the button has been repeatedly pressed since it was first held
+        uint32_t repeat_iterations = 0;
+};
+
+/**
+ * @brief A copy of the state of a gamepad as of a single update, see Gamepad::snapshot()
+ *
+ * This is a plain value, so it can be kept and passed between tasks freely.
+ */
+struct GamepadState {
+        /// When the gamepad was updated, in ms since the program started
+        uint32_t timestamp = 0;
+        /// Which buttons are held, bit i is set if button DIGITAL_L1 + i is held
+        uint16_t held = 0;
+        /// Which buttons were pressed during the update, bit i is set if button DIGITAL_L1 + i was pressed
+        uint16_t pressed = 0;
+        /// Which buttons were released during the update, bit i is set if button DIGITAL_L1 + i was released
+        uint16_t released = 0;
+        float LeftX = 0;
+        float LeftY = 0;
+        float RightX = 0;
+        float RightY = 0;
+        /// Which actions are held, bit i is set if the action with index i is held
+        uint32_t actions = 0;
+        /// Whether the controller was connected, the inputs are frozen or zeroed while it is not (see
+        /// Gamepad::set_disconnect_policy())
+        bool connected = true;
+        /// The timing of each button, indexed by DIGITAL_L1 + i
+        ButtonState buttons[12] {};
+
+        /**
+         * @brief Whether or not a button is held
+         *
+         * @param button Which button to check
+         */
+        constexpr bool is_held(pros::controller_digital_e_t button) const {
+            return this->held >> (button - pros::E_CONTROLLER_DIGITAL_L1) & 1;
+        }
+
+        /**
+         * @brief Get the timing of a button
+         *
+         * @param button Which button to return, this MUST be one of the digital buttons
+         */
+        constexpr const ButtonState& operator[](pros::controller_digital_e_t button) const {
+            return this->buttons[button - pros::E_CONTROLLER_DIGITAL_L1];
+        }
+};
+} // namespace gamepad
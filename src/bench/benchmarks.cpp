@@ -0,0 +1,166 @@
+#ifdef GAMEPAD_BENCHMARK
+
+#include "benchmarks.hpp"
+#include "gamepad/api.hpp"
+#include "gamepad/lock_policy.hpp"
+#include "pros/rtos.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef GAMEPAD_BENCHMARK_HOST
+#include <chrono>
+#endif
+
+namespace {
+/// How many times the heap has been allocated from, by anything
+std::atomic<uint64_t> allocations = 0;
+
+/// Every listener increments this, so the compiler can't throw them away
+volatile uint32_t fires = 0;
+
+/// How long each benchmark runs for
+constexpr uint64_t RUN_TIME = 200'000'000;
+
+uint64_t now_ns() {
+#ifdef GAMEPAD_BENCHMARK_HOST
+    // the host backend's pros::micros() is a virtual clock, which doesn't move by itself
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#else
+    return pros::c::micros() * 1000;
+#endif
+}
+
+/**
+ * @brief Runs an operation over and over for a while, then prints how long it took and how often it allocated
+ *
+ * @param name What is being measured
+ * @param ops How many operations each call to func does
+ * @param func Does the operations
+ */
+template <typename F> void measure(const char* name, uint32_t ops, F&& func) {
+    // the first call may allocate room that later calls reuse
+    func();
+    uint64_t calls = 0;
+    const uint64_t start_allocations = allocations.load(std::memory_order_relaxed);
+    const uint64_t start = now_ns();
+    uint64_t elapsed = 0;
+    do {
+        for (int i = 0; i < 64; ++i) func();
+        calls += 64;
+        elapsed = now_ns() - start;
+    } while (elapsed < RUN_TIME);
+    const double total = calls * ops;
+    std::printf("%-48s %10.1f ns/op %8.2f allocs/op\n", name, elapsed / total,
+                (allocations.load(std::memory_order_relaxed) - start_allocations) / total);
+}
+
+/**
+ * @brief Feeds the gamepad a button that alternates between held and released, and joysticks that sweep back and forth
+ */
+class SyntheticSource : public gamepad::InputSource {
+    public:
+        /// Which buttons alternate, bit i is DIGITAL_L1 + i
+        uint16_t toggled = 0;
+        /// Whether or not the joysticks move
+        bool sweep = false;
+
+        bool read(uint32_t now, gamepad::InputFrame& frame) override {
+            frame = {.timestamp = now};
+            this->held = !this->held;
+            if (this->held) frame.buttons = this->toggled;
+            if (this->sweep) {
+                this->position = this->position >= 127 ? -127 : this->position + 1;
+                for (auto& axis : frame.axes) axis = this->position;
+            }
+            return true;
+        }
+    private:
+        bool held = false;
+        int8_t position = 0;
+};
+
+void count_fire() { fires = fires + 1; }
+
+using BenchTable = gamepad::BindingTable<gamepad::Binding<pros::E_CONTROLLER_DIGITAL_A, gamepad::ON_PRESS, count_fire>>;
+
+std::vector<std::string> listener_names(size_t count) {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < count; ++i) names.push_back("bench" + std::to_string(i));
+    return names;
+}
+
+void update_benchmarks() {
+    SyntheticSource source;
+    gamepad::master.set_input_source(&source);
+    measure("update, idle", 1, [] { gamepad::master.update(); });
+
+    source.toggled = 1 << (pros::E_CONTROLLER_DIGITAL_A - pros::E_CONTROLLER_DIGITAL_L1);
+    for (size_t listeners : {0, 1, 16}) {
+        const auto names = listener_names(listeners);
+        for (const auto& name : names) gamepad::master.A.onPress(name, [] { fires = fires + 1; });
+        const std::string label = "update, A toggling, " + std::to_string(listeners) + " onPress listeners";
+        measure(label.c_str(), 1, [] { gamepad::master.update(); });
+        for (const auto& name : names) gamepad::master.A.removeListener(name);
+    }
+    measure("update<Table>, A toggling, 1 onPress binding", 1, [] { gamepad::master.update<BenchTable>(); });
+
+    // there is nothing to shape the joysticks with, so this measures the joystick thresholds of actions instead
+    source.toggled = 0;
+    source.sweep = true;
+    std::vector<gamepad::Action> actions;
+    for (int i = 0; i < 8; ++i) {
+        actions.push_back(gamepad::master.action("bench axis " + std::to_string(i)));
+        const auto axis = static_cast<pros::controller_analog_e_t>(i % 4);
+        gamepad::master.bind(actions.back(), gamepad::Input::axis(axis, i < 4 ? 64 : -64));
+    }
+    measure("update, joysticks sweeping, 8 axis actions", 1, [] { gamepad::master.update(); });
+    for (auto action : actions) gamepad::master.unbind(action);
+
+    gamepad::master.set_input_source(nullptr);
+}
+
+template <typename Lock> void handler_benchmarks(const char* lock_name) {
+    for (size_t listeners : {0, 1, 16}) {
+        gamepad::_impl::BasicEventHandler<Lock, std::string> handler;
+        for (const auto& name : listener_names(listeners)) handler.add_listener(name, [] { fires = fires + 1; });
+        const std::string label = std::string("fire, ") + lock_name + ", " + std::to_string(listeners) + " listeners";
+        measure(label.c_str(), 1, [&] { handler.fire(); });
+    }
+
+    gamepad::_impl::BasicEventHandler<Lock, std::string> handler;
+    const auto names = listener_names(64);
+    const std::string label = std::string("add then remove, ") + lock_name + ", 64 listeners";
+    measure(label.c_str(), 2 * names.size(), [&] {
+        for (const auto& name : names) handler.add_listener(name, [] { fires = fires + 1; });
+        for (const auto& name : names) handler.remove_listener(name);
+    });
+}
+} // namespace
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+
+namespace gamepad::bench {
+void run_all() {
+    std::printf("%-48s %16s %18s\n", "benchmark", "time", "allocations");
+    update_benchmarks();
+    handler_benchmarks<_impl::NoLock>("NoLock");
+    handler_benchmarks<_impl::SpinLock>("SpinLock");
+    handler_benchmarks<_impl::RecursiveMutex>("RecursiveMutex");
+}
+} // namespace gamepad::bench
+
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace gamepad::bench {
+/**
+ * @brief Measures the cost of updating a gamepad, and of adding, removing and firing listeners, and prints the time
+ * and heap allocations each operation takes to stdout
+ *
+ * This is only compiled when GAMEPAD_BENCHMARK is defined, by `make host-bench` on a computer, or by adding
+ * -DGAMEPAD_BENCHMARK to EXTRA_CXXFLAGS to run it on the brain. It uses gamepad::master, so the master controller
+ * must not be polled while it runs, and it replaces the global operator new to count allocations.
+ *
+ * @b Example:
+ * @code {.cpp}
+ *   void initialize() {
+ *       gamepad::bench::run_all();
+ *   }
+ * @endcode
+ */
+void run_all();
+} // namespace gamepad::bench
@@ -1,6 +1,8 @@
 #include "gamepad/button.hpp"
 #include "gamepad/todo.hpp"
 #include "pros/rtos.hpp"
+#include <atomic>
+#include <climits>
 #include <cstdint>
 #include <sys/types.h>
 
@@ -9,39 +11,45 @@ void Button::set_long_press_threshold(uint32_t threshold) const { this->long_pre
 
 void Button::set_repeat_cooldown(uint32_t cooldown) const { this->repeat_cooldown = cooldown; }
 
-bool Button::onPress(std::string listenerName, std::function<void(void)> func) const {
-    return this->onPressEvent.add_listener(std::move(listenerName) + "_user", std::move(func));
+void Button::set_catch_up_policy(CatchUpPolicy policy) const { this->catch_up_policy = policy; }
+
+bool Button::onPress(std::string listenerName, ButtonListener func, ListenerOptions options) const {
+    return this->onPressEvent.add_listener(std::move(listenerName) + "_user", std::move(func), options);
 }
 
-bool Button::onLongPress(std::string listenerName, std::function<void(void)> func) const {
-    return this->onLongPressEvent.add_listener(std::move(listenerName) + "_user", std::move(func));
+bool Button::onLongPress(std::string listenerName, ButtonListener func, ListenerOptions options) const {
+    return this->onLongPressEvent.add_listener(std::move(listenerName) + "_user", std::move(func), options);
 }
 
-bool Button::onRelease(std::string listenerName, std::function<void(void)> func) const {
-    return this->onReleaseEvent.add_listener(std::move(listenerName) + "_user", std::move(func));
+bool Button::onRelease(std::string listenerName, ButtonListener func, ListenerOptions options) const {
+    return this->onReleaseEvent.add_listener(std::move(listenerName) + "_user", std::move(func), options);
 }
 
-bool Button::onShortRelease(std::string listenerName, std::function<void(void)> func) const {
-    return this->onShortReleaseEvent.add_listener(std::move(listenerName) + "_user", std::move(func));
+bool Button::onShortRelease(std::string listenerName, ButtonListener func, ListenerOptions options) const {
+    return this->onShortReleaseEvent.add_listener(std::move(listenerName) + "_user", std::move(func), options);
 }
 
-bool Button::onLongRelease(std::string listenerName, std::function<void(void)> func) const {
-    return this->onLongReleaseEvent.add_listener(std::move(listenerName) + "_user", std::move(func));
+bool Button::onLongRelease(std::string listenerName, ButtonListener func, ListenerOptions options) const {
+    return this->onLongReleaseEvent.add_listener(std::move(listenerName) + "_user", std::move(func), options);
 }
 
-bool Button::onRepeatPress(std::string listenerName, std::function<void(void)> func) const {
-    return this->onRepeatPressEvent.add_listener(std::move(listenerName) + "_user", std::move(func));
+bool Button::onRepeatPress(std::string listenerName, ButtonListener func, ListenerOptions options) const {
+    return this->onRepeatPressEvent.add_listener(std::move(listenerName) + "_user", std::move(func), options);
 }
 
-bool Button::addListener(EventType event, std::string listenerName, std::function<void(void)> func) const {
+bool Button::addListener(EventType event, std::string listenerName, ButtonListener func,
+                         ListenerOptions options) const {
     switch (event) {
-        case gamepad::EventType::ON_PRESS: return this->onPress(std::move(listenerName), std::move(func));
-        case gamepad::EventType::ON_LONG_PRESS: return this->onLongPress(std::move(listenerName), std::move(func));
-        case gamepad::EventType::ON_RELEASE: return this->onRelease(std::move(listenerName), std::move(func));
+        case gamepad::EventType::ON_PRESS: return this->onPress(std::move(listenerName), std::move(func), options);
+        case gamepad::EventType::ON_LONG_PRESS:
+            return this->onLongPress(std::move(listenerName), std::move(func), options);
+        case gamepad::EventType::ON_RELEASE: return this->onRelease(std::move(listenerName), std::move(func), options);
         case gamepad::EventType::ON_SHORT_RELEASE:
-            return this->onShortRelease(std::move(listenerName), std::move(func));
-        case gamepad::EventType::ON_LONG_RELEASE: return this->onLongRelease(std::move(listenerName), std::move(func));
-        case gamepad::EventType::ON_REPEAT_PRESS: return this->onRepeatPress(std::move(listenerName), std::move(func));
+            return this->onShortRelease(std::move(listenerName), std::move(func), options);
+        case gamepad::EventType::ON_LONG_RELEASE:
+            return this->onLongRelease(std::move(listenerName), std::move(func), options);
+        case gamepad::EventType::ON_REPEAT_PRESS:
+            return this->onRepeatPress(std::move(listenerName), std::move(func), options);
         default:
             TODO("add error logging")
             errno = EINVAL;
@@ -58,34 +66,158 @@ bool Button::removeListener(std::string listenerName) const {
            this->onRepeatPressEvent.remove_listener(listenerName + "_user");
 }
 
-void Button::update(const bool is_held) {
+MutexStats Button::lock_stats(EventType event) const {
+    auto handler = this->get_handler(event);
+    if (handler == nullptr) {
+        TODO("add error logging")
+        errno = EINVAL;
+        return {};
+    }
+    return handler->lock_stats();
+}
+
+bool Button::wait_for(EventType event, uint32_t timeout) const {
+    auto handler = this->get_handler(event);
+    if (handler == nullptr) {
+        TODO("add error logging")
+        errno = EINVAL;
+        return false;
+    }
+    static std::atomic<uint32_t> waits = 0;
+    const std::string name = std::to_string(waits++) + "_wait";
+    const pros::task_t task = pros::c::task_get_current();
+    // a stale notification would end the wait before the event is fired
+    pros::c::task_notify_clear(task);
+    handler->add_listener(name, [task]() { pros::c::task_notify(task); }, {.priority = INT_MAX, .max_fires = 1});
+    if (pros::c::task_notify_take(true, timeout)) return true;
+    // the one-shot listener is already gone if the event was fired after the timeout, but before it was removed
+    if (handler->remove_listener(name)) return false;
+    pros::c::task_notify_take(true, 0);
+    return true;
+}
+
+void Button::sample(const bool is_held, const uint32_t now) {
+    this->fired_events = 0;
+    this->repeats_fired.clear();
     this->rising_edge = !this->is_pressed && is_held;
     this->falling_edge = this->is_pressed && !is_held;
     this->is_pressed = is_held;
-    if (is_held) this->time_held += pros::millis() - this->last_update_time;
-    else this->time_released += pros::millis() - this->last_update_time;
+    if (is_held) this->time_held += now - this->last_update_time;
+    else this->time_released += now - this->last_update_time;
+}
 
+void Button::fire(const uint32_t now, const uint32_t contexts) {
     if (this->rising_edge) {
-        this->onPressEvent.fire();
+        if (!this->onPressEvent.fire_in(contexts, this->event_details(ON_PRESS, now))) {
+            this->fired_events |= 1 << ON_PRESS;
+        }
     } else if (this->is_pressed && this->time_held >= this->long_press_threshold &&
-               this->last_long_press_time <= pros::millis() - this->time_held) {
-        this->onLongPressEvent.fire();
-        this->last_long_press_time = pros::millis();
-        this->last_repeat_time = pros::millis() - this->repeat_cooldown;
+               this->last_long_press_time <= now - this->time_held) {
+        // when catching up, pretend the long press fired right as the threshold was crossed
+        const uint32_t long_press_time = this->catch_up_policy == CATCH_UP_DROP
+                                             ? now
+                                             : now - this->time_held + this->long_press_threshold;
+        if (!this->onLongPressEvent.fire_in(contexts, this->event_details(ON_LONG_PRESS, now))) {
+            this->fired_events |= 1 << ON_LONG_PRESS;
+        }
+        this->last_long_press_time = long_press_time;
+        this->last_repeat_time = long_press_time - this->repeat_cooldown;
         this->repeat_iterations = 0;
+        if (this->catch_up_policy != CATCH_UP_DROP) this->fire_repeat_press(now, contexts);
     } else if (this->is_pressed && this->time_held >= this->long_press_threshold &&
-               pros::millis() - this->last_repeat_time >= this->repeat_cooldown) {
-        this->repeat_iterations++;
-        this->onRepeatPressEvent.fire();
-        this->last_repeat_time = pros::millis();
+               now - this->last_repeat_time >= this->repeat_cooldown) {
+        this->fire_repeat_press(now, contexts);
     } else if (this->falling_edge) {
-        this->onReleaseEvent.fire();
-        if (this->time_held < this->long_press_threshold) this->onShortReleaseEvent.fire();
-        else this->onLongReleaseEvent.fire();
+        if (!this->onReleaseEvent.fire_in(contexts, this->event_details(ON_RELEASE, now))) {
+            this->fired_events |= 1 << ON_RELEASE;
+        }
+        const EventType release = this->time_held < this->long_press_threshold ? ON_SHORT_RELEASE : ON_LONG_RELEASE;
+        auto& release_event = release == ON_SHORT_RELEASE ? this->onShortReleaseEvent : this->onLongReleaseEvent;
+        if (!release_event.fire_in(contexts, this->event_details(release, now))) this->fired_events |= 1 << release;
     }
 
     if (this->rising_edge) this->time_held = 0;
     if (this->falling_edge) this->time_released = 0;
-    this->last_update_time = pros::millis();
+    this->last_update_time = now;
+}
+
+void Button::reset(const uint32_t now) {
+    this->fired_events = 0;
+    this->repeats_fired.clear();
+    this->rising_edge = false;
+    this->falling_edge = false;
+    this->is_pressed = false;
+    this->time_held = 0;
+    this->time_released = 0;
+    this->repeat_iterations = 0;
+    this->repeat_count = 0;
+    this->last_update_time = now;
+}
+
+void Button::hold() {
+    this->fired_events = 0;
+    this->repeats_fired.clear();
+    this->rising_edge = false;
+    this->falling_edge = false;
+}
+
+ButtonEvent Button::event_details(EventType event, const uint32_t timestamp) const {
+    ButtonEvent details {.type = event, .timestamp = timestamp};
+    if (event != ON_PRESS) details.time_held = this->time_held;
+    if (event == ON_REPEAT_PRESS) {
+        details.repeat_iterations = this->repeat_iterations;
+        details.repeat_count = this->repeat_count;
+    }
+    return details;
+}
+
+ButtonEvent Button::fired_event(EventType event, uint32_t index) const {
+    ButtonEvent details = this->event_details(event, this->last_update_time);
+    // every repeat press fired by CATCH_UP_FIRE_ALL had its own iteration
+    if (event == ON_REPEAT_PRESS) details.repeat_iterations = this->repeats_fired[index];
+    return details;
+}
+
+_impl::EventHandler<std::string, const ButtonEvent&>* Button::get_handler(EventType event) const {
+    switch (event) {
+        case gamepad::EventType::ON_PRESS: return &this->onPressEvent;
+        case gamepad::EventType::ON_LONG_PRESS: return &this->onLongPressEvent;
+        case gamepad::EventType::ON_RELEASE: return &this->onReleaseEvent;
+        case gamepad::EventType::ON_SHORT_RELEASE: return &this->onShortReleaseEvent;
+        case gamepad::EventType::ON_LONG_RELEASE: return &this->onLongReleaseEvent;
+        case gamepad::EventType::ON_REPEAT_PRESS: return &this->onRepeatPressEvent;
+        default: return nullptr;
+    }
+}
+
+void Button::fire_repeat_press(const uint32_t now, const uint32_t contexts) {
+    if (this->catch_up_policy == CATCH_UP_DROP) {
+        this->repeat_iterations++;
+        this->repeat_count = 1;
+        if (!this->onRepeatPressEvent.fire_in(contexts, this->event_details(ON_REPEAT_PRESS, now))) {
+            this->repeats_fired.push_back(this->repeat_iterations);
+        }
+        this->last_repeat_time = now;
+        return;
+    }
+    // a cooldown of 0 means repeat on every update
+    const uint32_t due = this->repeat_cooldown == 0 ? 1 : (now - this->last_repeat_time) / this->repeat_cooldown;
+    if (due == 0) return;
+    this->last_repeat_time += due * this->repeat_cooldown;
+    if (this->catch_up_policy == CATCH_UP_COALESCE) {
+        this->repeat_iterations += due;
+        this->repeat_count = due;
+        if (!this->onRepeatPressEvent.fire_in(contexts, this->event_details(ON_REPEAT_PRESS, now))) {
+            this->repeats_fired.push_back(this->repeat_iterations);
+        }
+        return;
+    }
+    this->repeat_count = 1;
+    for (uint32_t i = 0; i < due; ++i) {
+        this->repeat_iterations++;
+        if (!this->onRepeatPressEvent.fire_in(contexts, this->event_details(ON_REPEAT_PRESS, now))) {
+            this->repeats_fired.push_back(this->repeat_iterations);
+        }
+    }
 }
 } // namespace gamepad
\ No newline at end of file
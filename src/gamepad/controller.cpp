@@ -2,24 +2,260 @@
 #include "gamepad/controller.hpp"
 #include "gamepad/todo.hpp"
 #include "pros/misc.h"
+#include "pros/rtos.hpp"
+#include <algorithm>
 #include <atomic>
+#include <mutex>
+#include <utility>
 
 namespace gamepad {
-void Gamepad::updateButton(pros::controller_digital_e_t button_id) {
-    Button Gamepad::*button = Gamepad::button_to_ptr(button_id);
-    bool is_held = this->controller.get_digital(button_id);
-    (this->*button).update(is_held);
+void Gamepad::update() {
+    if (!this->can_update()) return;
+    this->run_update();
 }
 
-void Gamepad::update() {
+void update_all() {
+    const uint32_t now = pros::millis();
+    const bool master = Gamepad::master.can_update();
+    const bool partner = Gamepad::partner.can_update();
+    // sample everything before firing anything, so no listener sees a half-updated frame
+    const uint32_t master_time = master ? Gamepad::master.sample(now) : 0;
+    const uint32_t partner_time = partner ? Gamepad::partner.sample(now) : 0;
+    if (master) Gamepad::master.process(now, master_time);
+    if (partner) Gamepad::partner.process(now, partner_time);
+    if (master) Gamepad::master.scheduler.run(master_time);
+    if (partner) Gamepad::partner.scheduler.run(partner_time);
+}
+
+bool Gamepad::can_update() const {
+    // only the polling task updates a polled gamepad, so events are never fired twice
+    return !this->polling || pros::c::task_get_current() == this->poll_task;
+}
+
+void Gamepad::run_update() {
+    const uint32_t now = pros::millis();
+    const uint32_t time = this->sample(now);
+    this->process(now, time);
+    // macros run last, so they see the state of every button as of this update
+    this->scheduler.run(time);
+}
+
+uint32_t Gamepad::sample(uint32_t now) {
+    InputFrame frame;
+    InputSource* source = this->source.load();
+    const bool connected = source->read(now, frame);
+    uint32_t time = source->has_own_clock() ? frame.timestamp : now;
+    // switching sources must not make the gamepad's time go backwards, compared as signed in case the clock wraps
+    if (this->status_known && static_cast<int32_t>(time - this->last_time) < 0) time = this->last_time;
+    this->last_time = time;
+    this->scheduler.set_time(time);
+    this->sampleStatus(now, time, connected);
+    // a disconnected controller reads as nothing held, which must not look like the driver letting go
+    this->inputs_sampled = connected;
+    if (!this->inputs_sampled) {
+        // whatever the disconnect policy keeps held, the edges of the last sample must not be reported again
+        for (int i = pros::E_CONTROLLER_DIGITAL_L1; i <= pros::E_CONTROLLER_DIGITAL_A; ++i) {
+            (this->*Gamepad::button_to_ptr(static_cast<pros::controller_digital_e_t>(i))).hold();
+        }
+        std::lock_guard lock(this->action_mutex);
+        for (auto& action : this->actions) action->hold();
+        return time;
+    }
+
+    uint16_t held_buttons = frame.buttons;
+    this->suppressed &= held_buttons;
+    held_buttons &= ~this->suppressed;
+    for (int i = 0; i <= pros::E_CONTROLLER_DIGITAL_A - pros::E_CONTROLLER_DIGITAL_L1; ++i) {
+        const auto id = static_cast<pros::controller_digital_e_t>(pros::E_CONTROLLER_DIGITAL_L1 + i);
+        (this->*Gamepad::button_to_ptr(id)).sample(held_buttons >> i & 1, time);
+    }
+
+    this->m_LeftX = frame.axes[0];
+    this->m_LeftY = frame.axes[1];
+    this->m_RightX = frame.axes[2];
+    this->m_RightY = frame.axes[3];
+
+    this->sampleActions(held_buttons, time);
+    return time;
+}
+
+void Gamepad::sampleStatus(uint32_t now, uint32_t time, bool connected) {
+    const bool first = !this->status_known;
+    this->status_known = true;
+    // the connection is checked every update, so the disconnect policy applies before any input is misread
+    if (!first && connected != this->connected) {
+        if (connected) {
+            this->reconnected_pending = true;
+            this->resume(time);
+        } else {
+            this->disconnected_pending = true;
+            this->neutralize(time);
+        }
+    }
+    this->connected = connected;
+    // a disconnected controller has no battery to report
+    if ((!first && now - this->last_status < this->status_period) || this->controller.is_connected() != 1) return;
+    this->last_status = now;
+    const int32_t capacity = this->controller.get_battery_capacity();
+    this->capacity = capacity;
+    this->level = this->controller.get_battery_level();
+    const int32_t threshold = this->low_battery_threshold;
+    if (!this->battery_low && capacity < threshold) {
+        this->battery_low = true;
+        this->low_battery_pending = true;
+    } else if (this->battery_low && capacity >= threshold + 5) {
+        this->battery_low = false;
+    }
+}
+
+void Gamepad::neutralize(uint32_t now) {
+    if (this->disconnect_policy != DISCONNECT_ZERO) return;
     for (int i = pros::E_CONTROLLER_DIGITAL_L1; i <= pros::E_CONTROLLER_DIGITAL_A; ++i) {
-        this->updateButton(static_cast<pros::controller_digital_e_t>(i));
+        (this->*Gamepad::button_to_ptr(static_cast<pros::controller_digital_e_t>(i))).reset(now);
+    }
+    this->m_LeftX = this->m_LeftY = this->m_RightX = this->m_RightY = 0;
+    std::lock_guard lock(this->action_mutex);
+    for (auto& action : this->actions) action->reset(now);
+    this->action_state.store(0, std::memory_order_relaxed);
+}
+
+void Gamepad::resume(uint32_t now) {
+    if (this->disconnect_policy == DISCONNECT_ZERO) {
+        // the buttons were reset on disconnect, so a button that is still held would otherwise look like a new press
+        this->suppressed = UINT16_MAX;
+        return;
+    }
+    // the buttons were frozen, so the drop out doesn't count towards how long they were held or released for
+    for (int i = pros::E_CONTROLLER_DIGITAL_L1; i <= pros::E_CONTROLLER_DIGITAL_A; ++i) {
+        (this->*Gamepad::button_to_ptr(static_cast<pros::controller_digital_e_t>(i))).last_update_time = now;
+    }
+    std::lock_guard lock(this->action_mutex);
+    for (auto& action : this->actions) action->last_update_time = now;
+}
+
+void Gamepad::process(uint32_t now, uint32_t time) {
+    // every button sees the same contexts, even if a listener switches context part way through
+    const uint32_t contexts = this->active_contexts.load();
+    if (std::exchange(this->disconnected_pending, false)) this->onDisconnectEvent.fire_in(contexts);
+    if (std::exchange(this->reconnected_pending, false)) this->onReconnectEvent.fire_in(contexts);
+    if (std::exchange(this->low_battery_pending, false)) this->onLowBatteryEvent.fire_in(contexts);
+    GamepadState next;
+    next.timestamp = time;
+    for (int i = 0; i <= pros::E_CONTROLLER_DIGITAL_A - pros::E_CONTROLLER_DIGITAL_L1; ++i) {
+        const auto id = static_cast<pros::controller_digital_e_t>(pros::E_CONTROLLER_DIGITAL_L1 + i);
+        Button& button = this->*Gamepad::button_to_ptr(id);
+        if (this->inputs_sampled) {
+            button.fire(time, contexts);
+            if (button.rising_edge) next.pressed |= 1 << i;
+            if (button.falling_edge) next.released |= 1 << i;
+        }
+        if (button.is_pressed) next.held |= 1 << i;
+        next.buttons[i] = {button.time_held, button.time_released, button.repeat_iterations};
+    }
+
+    if (this->inputs_sampled) {
+        std::lock_guard lock(this->action_mutex);
+        for (auto& action : this->actions) action->fire(time, contexts);
+    }
+
+    next.LeftX = this->m_LeftX;
+    next.LeftY = this->m_LeftY;
+    next.RightX = this->m_RightX;
+    next.RightY = this->m_RightY;
+    next.actions = this->held_actions();
+    next.connected = this->connected;
+    this->state.store(next);
+    this->recorder.record(next);
+
+    this->send(now);
+}
+
+void Gamepad::send(uint32_t now) {
+    if (now - this->last_send < this->send_period) return;
+    // a rumble only takes the link once per pattern, so text is only held up briefly
+    if (this->rumble.send(now) || this->screen.send()) this->last_send = now;
+}
+
+void Gamepad::set_send_period(uint32_t period) { this->send_period = period; }
+
+void Gamepad::set_status_period(uint32_t period) { this->status_period = period; }
+
+void Gamepad::set_input_source(InputSource* source) {
+    this->source = source == nullptr ? &this->controller_source : source;
+}
+
+void Gamepad::set_disconnect_policy(DisconnectPolicy policy) { this->disconnect_policy = policy; }
+
+void Gamepad::set_low_battery_threshold(int32_t threshold) { this->low_battery_threshold = threshold; }
+
+bool Gamepad::onDisconnect(std::string listenerName, GamepadListener func, ListenerOptions options) {
+    return this->onDisconnectEvent.add_listener(std::move(listenerName) + "_user", std::move(func), options);
+}
+
+bool Gamepad::onReconnect(std::string listenerName, GamepadListener func, ListenerOptions options) {
+    return this->onReconnectEvent.add_listener(std::move(listenerName) + "_user", std::move(func), options);
+}
+
+bool Gamepad::onLowBattery(std::string listenerName, GamepadListener func, ListenerOptions options) {
+    return this->onLowBatteryEvent.add_listener(std::move(listenerName) + "_user", std::move(func), options);
+}
+
+bool Gamepad::removeListener(std::string listenerName) {
+    return this->onDisconnectEvent.remove_listener(listenerName + "_user") ||
+           this->onReconnectEvent.remove_listener(listenerName + "_user") ||
+           this->onLowBatteryEvent.remove_listener(listenerName + "_user");
+}
+
+bool Gamepad::start_recording(const char* path, size_t buffer_size) {
+    return this->recorder.start(path, pros::millis(), buffer_size);
+}
+
+void Gamepad::stop_recording() { this->recorder.stop(); }
+
+bool Gamepad::is_recording() const { return this->recorder.is_recording(); }
+
+GamepadState Gamepad::snapshot() const { return this->state.load(); }
+
+bool Gamepad::start_polling(uint32_t period, uint32_t priority) {
+    std::lock_guard lock(this->poll_mutex);
+    this->poll_period = period;
+    if (this->poll_task != nullptr) {
+        // wake the polling task up if it was stopped
+        if (!this->polling.exchange(true)) pros::c::task_notify(this->poll_task);
+        return true;
     }
+    this->polling = true;
+    this->poll_task = pros::Task::create([this] { this->poll(); }, priority, TASK_STACK_DEPTH_DEFAULT, "gamepad");
+    if (this->poll_task == nullptr) this->polling = false;
+    return this->polling;
+}
+
+void Gamepad::stop_polling() { this->polling = false; }
 
-    this->m_LeftX = this->controller.get_analog(pros::E_CONTROLLER_ANALOG_LEFT_X);
-    this->m_LeftY = this->controller.get_analog(pros::E_CONTROLLER_ANALOG_LEFT_Y);
-    this->m_RightX = this->controller.get_analog(pros::E_CONTROLLER_ANALOG_RIGHT_X);
-    this->m_RightY = this->controller.get_analog(pros::E_CONTROLLER_ANALOG_RIGHT_Y);
+void Gamepad::poll() {
+    uint32_t time = pros::millis();
+    while (true) {
+        if (!this->polling) {
+            // the task is kept around while stopped, so polling can be restarted without creating a new task
+            pros::c::task_notify_take(true, TIMEOUT_MAX);
+            time = pros::millis();
+            continue;
+        }
+        this->run_update();
+        pros::c::task_delay_until(&time, this->poll_period);
+    }
+}
+
+void Gamepad::sampleActions(uint16_t held_buttons, uint32_t now) {
+    std::lock_guard lock(this->action_mutex);
+    if (this->actions.empty()) return;
+    const float axes[] {this->m_LeftX, this->m_LeftY, this->m_RightX, this->m_RightY};
+    uint32_t held = 0;
+    for (const auto& binding : this->action_bindings) {
+        if (binding.input.is_active(held_buttons, axes)) held |= 1u << binding.action.index();
+    }
+    this->action_state.store(held, std::memory_order_relaxed);
+    for (size_t i = 0; i < this->actions.size(); ++i) this->actions[i]->sample(held >> i & 1, now);
 }
 
 const Button& Gamepad::operator[](pros::controller_digital_e_t button) { return this->*Gamepad::button_to_ptr(button); }
@@ -37,6 +273,91 @@ float Gamepad::operator[](pros::controller_analog_e_t axis) {
     }
 }
 
+Context Gamepad::context(const std::string& name) {
+    std::lock_guard lock(this->context_mutex);
+    auto i = std::find(this->context_names.begin(), this->context_names.end(), name);
+    if (i != this->context_names.end()) return Context(2u << (i - this->context_names.begin()));
+    if (this->context_names.size() >= 31) {
+        errno = ENOSPC;
+        return Context();
+    }
+    this->context_names.push_back(name);
+    return Context(2u << (this->context_names.size() - 1));
+}
+
+bool Gamepad::push_context(Context context, bool exclusive) {
+    std::lock_guard lock(this->context_mutex);
+    if (this->context_depth >= this->context_stack.size()) {
+        errno = ENOSPC;
+        return false;
+    }
+    const uint32_t below = exclusive ? Context().mask() : this->active_contexts.load();
+    this->context_stack[this->context_depth++] = below | context.mask();
+    this->active_contexts = this->context_stack[this->context_depth - 1];
+    return true;
+}
+
+bool Gamepad::pop_context() {
+    std::lock_guard lock(this->context_mutex);
+    if (this->context_depth == 0) return false;
+    --this->context_depth;
+    this->active_contexts = this->context_depth ? this->context_stack[this->context_depth - 1] : Context().mask();
+    return true;
+}
+
+void Gamepad::set_context(Context context) {
+    std::lock_guard lock(this->context_mutex);
+    this->context_depth = 0;
+    this->active_contexts = Context().mask();
+    this->push_context(context);
+}
+
+bool Gamepad::is_active(Context context) const { return this->active_contexts.load() & context.mask(); }
+
+Action Gamepad::action(const std::string& name) {
+    std::lock_guard lock(this->action_mutex);
+    auto i = std::find(this->action_names.begin(), this->action_names.end(), name);
+    if (i != this->action_names.end()) return Action(i - this->action_names.begin());
+    if (this->action_names.size() >= 32) {
+        errno = ENOSPC;
+        return Action();
+    }
+    this->action_names.push_back(name);
+    this->actions.push_back(std::make_unique<Button>());
+    return Action(this->action_names.size() - 1);
+}
+
+bool Gamepad::bind(Action action, Input input) {
+    std::lock_guard lock(this->action_mutex);
+    if (!action.is_valid() || action.index() >= this->actions.size()) {
+        errno = EINVAL;
+        return false;
+    }
+    this->action_bindings.push_back({action, input});
+    return true;
+}
+
+bool Gamepad::unbind(Action action) {
+    std::lock_guard lock(this->action_mutex);
+    return std::erase_if(this->action_bindings, [&](const ActionBinding& binding) { return binding.action == action; });
+}
+
+bool Gamepad::rebind(Action action, Input input) {
+    std::lock_guard lock(this->action_mutex);
+    this->unbind(action);
+    return this->bind(action, input);
+}
+
+const Button& Gamepad::operator[](Action action) {
+    std::lock_guard lock(this->action_mutex);
+    if (!action.is_valid() || action.index() >= this->actions.size()) {
+        TODO("add error logging")
+        errno = EINVAL;
+        return this->Fake;
+    }
+    return *this->actions[action.index()];
+}
+
 std::string Gamepad::unique_name() {
     static std::atomic<uint32_t> i = 0;
     return std::to_string(i++) + "_internal";
@@ -63,3 +384,7 @@ Button Gamepad::*Gamepad::button_to_ptr(pros::controller_digital_e_t button) {
     }
 }
 } // namespace gamepad
+
+namespace gamepad::_impl {
+Scheduler& default_scheduler() { return Gamepad::master.scheduler; }
+} // namespace gamepad::_impl
@@ -0,0 +1,17 @@
+#include "gamepad/input_source.hpp"
+#include "pros/misc.h"
+
+namespace gamepad::_impl {
+bool ControllerSource::read(uint32_t now, InputFrame& frame) {
+    if (this->controller.is_connected() != 1) return false;
+    frame = {.timestamp = now};
+    for (int i = 0; i <= pros::E_CONTROLLER_DIGITAL_A - pros::E_CONTROLLER_DIGITAL_L1; ++i) {
+        const auto id = static_cast<pros::controller_digital_e_t>(pros::E_CONTROLLER_DIGITAL_L1 + i);
+        if (this->controller.get_digital(id)) frame.buttons |= 1 << i;
+    }
+    for (int i = 0; i < 4; ++i) {
+        frame.axes[i] = this->controller.get_analog(static_cast<pros::controller_analog_e_t>(i));
+    }
+    return true;
+}
+} // namespace gamepad::_impl
@@ -0,0 +1,156 @@
+#include "gamepad/menu.hpp"
+#include "gamepad/button.hpp"
+#include "gamepad/screen.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+namespace gamepad {
+void Toggle::format(char* out, size_t size) const { std::snprintf(out, size, "%s", this->value ? "on" : "off"); }
+
+bool Toggle::adjust(int) {
+    this->value = !this->value;
+    if (this->on_change) this->on_change(this->value);
+    return true;
+}
+
+void Slider::format(char* out, size_t size) const { std::snprintf(out, size, "%g", this->value); }
+
+bool Slider::adjust(int direction) {
+    // count steps from the minimum, so rounding errors don't build up as the slider is moved back and forth
+    const float steps = std::round((this->value - this->min) / this->step) + direction;
+    const float value = std::clamp(this->min + steps * this->step, this->min, this->max);
+    if (value == this->value) return false;
+    this->value = value;
+    if (this->on_change) this->on_change(this->value);
+    return true;
+}
+
+void List::format(char* out, size_t size) const {
+    std::snprintf(out, size, "%s", this->options.empty() ? "" : this->options[this->index].c_str());
+}
+
+bool List::adjust(int direction) {
+    if (this->options.size() < 2) return false;
+    this->index = (this->index + this->options.size() + direction) % this->options.size();
+    if (this->on_change) this->on_change(this->index);
+    return true;
+}
+
+Menu::Menu(Gamepad& gamepad, std::string name)
+    : gamepad(gamepad),
+      name(std::move(name)),
+      context(gamepad.context("menu " + this->name)) {
+    // the menu's presses are consumed, so listeners outside of the menu's context don't see them either
+    const ListenerOptions options {.priority = 100, .context = this->context};
+    for (auto [button, key, action, direction] : this->navigation()) {
+        auto listener = [this, action, direction](const ButtonEvent& event) {
+            event.consume();
+            (this->*action)(direction);
+        };
+        button->onPress(this->listener_name(key), listener, options);
+        button->onRepeatPress(this->listener_name(key) + "_repeat", listener, options);
+    }
+    gamepad.A.onPress(
+        this->listener_name("select"),
+        [this](const ButtonEvent& event) {
+            event.consume();
+            this->select();
+        },
+        options);
+    gamepad.B.onPress(
+        this->listener_name("close"),
+        [this](const ButtonEvent& event) {
+            event.consume();
+            this->close();
+        },
+        options);
+}
+
+Menu::~Menu() {
+    this->close();
+    for (auto [button, key, action, direction] : this->navigation()) {
+        button->removeListener(this->listener_name(key));
+        button->removeListener(this->listener_name(key) + "_repeat");
+    }
+    this->gamepad.A.removeListener(this->listener_name("select"));
+    this->gamepad.B.removeListener(this->listener_name("close"));
+}
+
+bool Menu::open() {
+    std::lock_guard lock(this->mutex);
+    if (this->opened || !this->gamepad.push_context(this->context, true)) return false;
+    this->opened = true;
+    // anything else on the screen is replaced by the menu
+    this->gamepad.screen.clear();
+    this->render();
+    return true;
+}
+
+bool Menu::close() {
+    std::lock_guard lock(this->mutex);
+    if (!this->opened) return false;
+    this->gamepad.pop_context();
+    this->opened = false;
+    this->gamepad.screen.clear();
+    return true;
+}
+
+void Menu::move(int direction) {
+    std::lock_guard lock(this->mutex);
+    if (this->widgets.empty()) return;
+    const size_t cursor = std::clamp<int>(this->cursor + direction, 0, this->widgets.size() - 1);
+    if (cursor == this->cursor) return;
+    this->cursor = cursor;
+    // scroll just far enough to keep the cursor on the screen
+    if (this->cursor < this->top) this->top = this->cursor;
+    if (this->cursor >= this->top + Screen::LINES) this->top = this->cursor - Screen::LINES + 1;
+    this->render();
+}
+
+void Menu::adjust(int direction) {
+    std::lock_guard lock(this->mutex);
+    if (this->widgets.empty()) return;
+    if (this->widgets[this->cursor]->adjust(direction)) this->render();
+}
+
+void Menu::select() {
+    std::lock_guard lock(this->mutex);
+    if (this->widgets.empty()) return;
+    if (this->widgets[this->cursor]->select()) this->render();
+}
+
+void Menu::render() {
+    std::lock_guard lock(this->mutex);
+    if (!this->opened) return;
+    for (uint8_t line = 0; line < Screen::LINES; ++line) {
+        const size_t index = this->top + line;
+        if (index >= this->widgets.size()) {
+            this->gamepad.screen.clear_line(line);
+            continue;
+        }
+        const Widget& widget = *this->widgets[index];
+        char text[Screen::COLUMNS + 1];
+        std::memset(text, ' ', Screen::COLUMNS);
+        text[0] = index == this->cursor ? '>' : ' ';
+        std::memcpy(text + 1, widget.label.data(), std::min<size_t>(widget.label.size(), Screen::COLUMNS - 1));
+        // the value is right aligned, and takes priority over a long label
+        char value[Screen::COLUMNS];
+        widget.format(value, sizeof(value));
+        const size_t length = std::strlen(value);
+        std::memcpy(text + Screen::COLUMNS - length, value, length);
+        this->gamepad.screen.set_line(line, {text, Screen::COLUMNS});
+    }
+}
+
+std::array<Menu::Navigation, 4> Menu::navigation() const {
+    return {{{&this->gamepad.Up, "up", &Menu::move, -1},
+             {&this->gamepad.Down, "down", &Menu::move, 1},
+             {&this->gamepad.Left, "left", &Menu::adjust, -1},
+             {&this->gamepad.Right, "right", &Menu::adjust, 1}}};
+}
+
+std::string Menu::listener_name(const char* button) const { return "menu_" + this->name + "_" + button; }
+} // namespace gamepad
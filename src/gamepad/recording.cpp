@@ -0,0 +1,366 @@
+#include "gamepad/recording.hpp"
+#include "gamepad/todo.hpp"
+#include "pros/rtos.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+namespace gamepad::_impl {
+size_t FrameEncoder::begin(uint32_t start, uint8_t* out) {
+    this->last = {.timestamp = start};
+    this->last_interval = 0;
+    this->repeats = 0;
+    this->started = false;
+    std::memcpy(out, "GPR1", 4);
+    for (int i = 0; i < 4; ++i) out[4 + i] = start >> 8 * i;
+    return HEADER_SIZE;
+}
+
+size_t FrameEncoder::encode(const InputFrame& frame, uint8_t* out) {
+    const uint32_t interval = frame.timestamp - this->last.timestamp;
+    InputFrame repeated = this->last;
+    repeated.timestamp = frame.timestamp;
+    if (this->started && interval == this->last_interval && frame == repeated) {
+        this->last.timestamp = frame.timestamp;
+        // a repeat record holds at most 128 frames
+        return ++this->repeats == 128 ? this->finish(out) : 0;
+    }
+
+    size_t size = this->finish(out);
+    uint8_t tag = 0;
+    if (frame.buttons != this->last.buttons) tag |= 1;
+    for (int i = 0; i < 4; ++i) {
+        if (frame.axes[i] != this->last.axes[i]) tag |= 2 << i;
+    }
+    if (interval != this->last_interval) tag |= 1 << 5;
+    out[size++] = tag;
+    if (tag & 1 << 5) {
+        uint32_t value = interval;
+        for (; value >= 0x80; value >>= 7) out[size++] = value | 0x80;
+        out[size++] = value;
+    }
+    if (tag & 1) {
+        out[size++] = frame.buttons;
+        out[size++] = frame.buttons >> 8;
+    }
+    for (int i = 0; i < 4; ++i) {
+        if (tag & 2 << i) out[size++] = frame.axes[i];
+    }
+    this->last = frame;
+    this->last_interval = interval;
+    this->started = true;
+    return size;
+}
+
+size_t FrameEncoder::finish(uint8_t* out) {
+    if (this->repeats == 0) return 0;
+    out[0] = 0x80 | (this->repeats - 1);
+    this->repeats = 0;
+    return 1;
+}
+
+bool FrameDecoder::begin(Source source) {
+    this->source = std::move(source);
+    this->position = 0;
+    this->size = 0;
+    this->last_interval = 0;
+    this->repeats = 0;
+    this->started = false;
+    uint8_t header[FrameEncoder::HEADER_SIZE];
+    for (auto& byte : header) {
+        const int next = this->get();
+        if (next == EOF) {
+            errno = EINVAL;
+            return false;
+        }
+        byte = next;
+    }
+    if (std::memcmp(header, "GPR1", 4) != 0) {
+        errno = EINVAL;
+        return false;
+    }
+    this->last = {.timestamp = header[4] | header[5] << 8 | header[6] << 16 | static_cast<uint32_t>(header[7]) << 24};
+    return true;
+}
+
+bool FrameDecoder::next(InputFrame& frame) {
+    if (this->repeats > 0) {
+        --this->repeats;
+    } else {
+        const int tag = this->get();
+        if (tag == EOF) return false;
+        if (tag & 0x80) {
+            // there is no frame to repeat yet, so the recording is corrupt
+            if (!this->started) return false;
+            this->repeats = tag & 0x7f;
+        } else {
+            // a recording that was cut off part way through a record ends at the record before it
+            if (tag & 1 << 5) {
+                uint32_t interval = 0;
+                for (int shift = 0;; shift += 7) {
+                    const int byte = this->get();
+                    if (byte == EOF || shift > 28) return false;
+                    interval |= static_cast<uint32_t>(byte & 0x7f) << shift;
+                    if (!(byte & 0x80)) break;
+                }
+                this->last_interval = interval;
+            }
+            if (tag & 1) {
+                const int low = this->get();
+                const int high = this->get();
+                if (high == EOF) return false;
+                this->last.buttons = low | high << 8;
+            }
+            for (int i = 0; i < 4; ++i) {
+                if (!(tag & 2 << i)) continue;
+                const int axis = this->get();
+                if (axis == EOF) return false;
+                this->last.axes[i] = static_cast<int8_t>(axis);
+            }
+            this->started = true;
+        }
+    }
+    this->last.timestamp += this->last_interval;
+    frame = this->last;
+    return true;
+}
+
+int FrameDecoder::get() {
+    if (this->position == this->size) {
+        this->position = 0;
+        this->size = this->source(this->block, sizeof(this->block));
+        if (this->size == 0) return EOF;
+    }
+    return this->block[this->position++];
+}
+
+void ByteRing::reset(size_t capacity) {
+    this->data.reset(new uint8_t[capacity]);
+    this->capacity = capacity;
+    this->head = 0;
+    this->tail = 0;
+}
+
+bool ByteRing::push(const uint8_t* bytes, size_t size) {
+    if (this->capacity - this->size() < size) return false;
+    const size_t head = this->head.load(std::memory_order_relaxed);
+    const size_t offset = head % this->capacity;
+    const size_t first = std::min(size, this->capacity - offset);
+    std::memcpy(&this->data[offset], bytes, first);
+    std::memcpy(&this->data[0], bytes + first, size - first);
+    this->head.store(head + size, std::memory_order_release);
+    return true;
+}
+
+size_t ByteRing::pop(uint8_t* out, size_t max) {
+    const size_t tail = this->tail.load(std::memory_order_relaxed);
+    const size_t size = std::min(max, this->head.load(std::memory_order_acquire) - tail);
+    const size_t offset = tail % this->capacity;
+    const size_t first = std::min(size, this->capacity - offset);
+    std::memcpy(out, &this->data[offset], first);
+    std::memcpy(out + first, &this->data[0], size - first);
+    this->tail.store(tail + size, std::memory_order_release);
+    return size;
+}
+
+bool Recorder::start(const char* path, uint32_t now, size_t buffer_size) {
+    std::lock_guard lock(this->mutex);
+    if (this->is_recording()) {
+        errno = EBUSY;
+        return false;
+    }
+    if (buffer_size < BLOCK_SIZE) {
+        errno = EINVAL;
+        return false;
+    }
+    if (this->task == nullptr) {
+        // the task is kept around between recordings, and only ever waits on the SD card
+        this->task = pros::Task::create([this] { this->write(); }, TASK_PRIORITY_MIN, TASK_STACK_DEPTH_DEFAULT,
+                                        "gamepad recorder");
+        if (this->task == nullptr) return false;
+    }
+    FILE* file = std::fopen(path, "wb");
+    if (file == nullptr) return false;
+    // the writing task doesn't touch the buffer while there is no file
+    this->ring.reset(buffer_size);
+    uint8_t header[FrameEncoder::HEADER_SIZE];
+    this->ring.push(header, this->encoder.begin(now, header));
+    this->stopping = false;
+    this->file = file;
+    this->active = true;
+    return true;
+}
+
+void Recorder::stop() {
+    std::lock_guard lock(this->mutex);
+    if (!this->active) return;
+    uint8_t bytes[1];
+    this->push(bytes, this->encoder.finish(bytes));
+    if (!this->active.exchange(false)) return;
+    this->stopping = true;
+    pros::c::task_notify(this->task);
+}
+
+void Recorder::record(const GamepadState& state) {
+    // don't take the mutex on every update when nothing is being recorded
+    if (!this->active.load(std::memory_order_relaxed)) return;
+    std::lock_guard lock(this->mutex);
+    if (!this->active) return;
+    const InputFrame frame {
+        .timestamp = state.timestamp,
+        .buttons = state.held,
+        .axes = {static_cast<int8_t>(state.LeftX), static_cast<int8_t>(state.LeftY), static_cast<int8_t>(state.RightX),
+                 static_cast<int8_t>(state.RightY)},
+    };
+    uint8_t bytes[FrameEncoder::MAX_ENCODED_SIZE];
+    this->push(bytes, this->encoder.encode(frame, bytes));
+}
+
+void Recorder::push(const uint8_t* bytes, size_t size) {
+    if (size == 0) return;
+    const size_t before = this->ring.size();
+    if (!this->ring.push(bytes, size)) {
+        // the SD card can't keep up, so end the recording at the last whole record instead of blocking the update
+        TODO("add error logging")
+        this->active = false;
+        this->stopping = true;
+        pros::c::task_notify(this->task);
+        return;
+    }
+    // only wake the writing task up once there is a whole block for it
+    if (before < BLOCK_SIZE && before + size >= BLOCK_SIZE) pros::c::task_notify(this->task);
+}
+
+void Recorder::write() {
+    uint8_t block[BLOCK_SIZE];
+    while (true) {
+        pros::c::task_notify_take(true, TIMEOUT_MAX);
+        FILE* file = this->file;
+        if (file == nullptr) continue;
+        // checked before emptying the buffer, so everything pushed before stopping is written
+        const bool stopping = this->stopping;
+        while (this->ring.size() >= BLOCK_SIZE || (stopping && this->ring.size() > 0)) {
+            const size_t size = this->ring.pop(block, BLOCK_SIZE);
+            if (std::fwrite(block, 1, size, file) != size) {
+                TODO("add error logging")
+            }
+        }
+        if (!stopping) continue;
+        std::fclose(file);
+        this->stopping = false;
+        this->file = nullptr;
+    }
+}
+} // namespace gamepad::_impl
+
+namespace gamepad {
+Replay::~Replay() { this->close(); }
+
+bool Replay::open(const char* path, size_t buffer_size) {
+    std::lock_guard lock(this->mutex);
+    this->close();
+    if (buffer_size < BLOCK_SIZE) {
+        errno = EINVAL;
+        return false;
+    }
+    FILE* file = std::fopen(path, "rb");
+    if (file == nullptr) return false;
+    // the reading task isn't running, so nothing else touches the buffer or the file yet
+    this->ring.reset(buffer_size);
+    this->file = file;
+    this->ended = false;
+    this->task_done = false;
+    this->task = pros::Task::create([this] { this->prefetch(); }, TASK_PRIORITY_MIN, TASK_STACK_DEPTH_DEFAULT,
+                                    "gamepad replay");
+    if (this->task == nullptr) {
+        std::fclose(file);
+        this->file = nullptr;
+        this->task_done = true;
+        return false;
+    }
+    // the header is waited for here, so the update never has to
+    if (!this->decoder.begin([this](uint8_t* out, size_t max) { return this->fill(out, max); })) {
+        this->close();
+        errno = EINVAL;
+        return false;
+    }
+    this->started = false;
+    this->finished = false;
+    return true;
+}
+
+void Replay::close() {
+    std::lock_guard lock(this->mutex);
+    this->finished = true;
+    if (this->task_done) return;
+    // set before the file is taken away, so the reading task is sure to see who to tell when it exits
+    this->waiter = pros::c::task_get_current();
+    {
+        std::lock_guard file_lock(this->file_mutex);
+        std::fclose(this->file);
+        this->file = nullptr;
+    }
+    // wait for the reading task to exit, since it uses this replay until then
+    pros::c::task_notify(this->task);
+    while (!this->task_done) pros::c::task_notify_take(true, 10);
+    this->waiter = nullptr;
+}
+
+bool Replay::read(uint32_t now, InputFrame& frame) {
+    std::lock_guard lock(this->mutex);
+    if (!this->finished && this->decoder.next(frame)) {
+        // the first frame plays now, and every frame after it keeps the spacing it was recorded with
+        if (!this->started) this->shift = now - frame.timestamp;
+        this->started = true;
+        frame.timestamp += this->shift;
+        return true;
+    }
+    // read as disconnected once the recording ends, so the gamepad's disconnect policy decides what is held
+    this->finished = true;
+    frame = {.timestamp = now};
+    return false;
+}
+
+size_t Replay::fill(uint8_t* out, size_t max) {
+    while (true) {
+        // checked before taking from the buffer, so nothing read before the end is missed
+        const bool ended = this->ended;
+        const size_t size = this->ring.pop(out, max);
+        if (size > 0) {
+            pros::c::task_notify(this->task);
+            return size;
+        }
+        if (ended) return 0;
+        // the SD card has fallen behind the replay, so wait for it instead of skipping frames
+        this->waiter = pros::c::task_get_current();
+        if (this->ring.size() == 0 && !this->ended) pros::c::task_notify_take(true, 10);
+        this->waiter = nullptr;
+    }
+}
+
+void Replay::prefetch() {
+    uint8_t block[BLOCK_SIZE];
+    while (true) {
+        {
+            std::lock_guard lock(this->file_mutex);
+            if (this->file == nullptr) break;
+            while (!this->ended && this->ring.room() >= BLOCK_SIZE) {
+                const size_t size = std::fread(block, 1, BLOCK_SIZE, this->file);
+                this->ring.push(block, size);
+                if (size < BLOCK_SIZE) this->ended = true;
+                // pairs with fill() setting the waiter before it checks the buffer, so one of them sees the other
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (pros::task_t waiter = this->waiter) pros::c::task_notify(waiter);
+            }
+        }
+        // woken whenever the replay takes from the buffer, or is closed
+        pros::c::task_notify_take(true, TIMEOUT_MAX);
+    }
+    // nothing of this replay may be touched once it is marked done, since it may be destroyed straight away
+    const pros::task_t waiter = this->waiter;
+    this->task_done = true;
+    if (waiter != nullptr) pros::c::task_notify(waiter);
+}
+} // namespace gamepad
@@ -0,0 +1,59 @@
+#include "gamepad/recursive_mutex.hpp"
+#include "pros/rtos.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+
+namespace gamepad::_impl {
+namespace {
+/**
+ * @brief Reports a mutex that can't be used and aborts, since every caller relies on the mutex for its safety
+ */
+[[noreturn]] void fail(const char* what) {
+    std::fprintf(stderr, "gamepad: %s (errno %d)\n", what, errno);
+    std::abort();
+}
+} // namespace
+
+RecursiveMutex::RecursiveMutex()
+    : mutex(pros::c::mutex_recursive_create()) {
+    if (this->mutex == nullptr) fail("could not create a mutex");
+}
+
+bool RecursiveMutex::take(std::uint32_t timeout) {
+#ifdef GAMEPAD_MUTEX_STATS
+    if (pros::c::mutex_recursive_take(this->mutex, 0)) {
+        ++this->counters.acquisitions;
+        return true;
+    }
+    if (timeout == 0) return false;
+    const uint64_t start = pros::c::micros();
+    if (!pros::c::mutex_recursive_take(this->mutex, timeout)) return false;
+    // the mutex is held from here on, so the stats can be updated without any other synchronization
+    const uint32_t wait = pros::c::micros() - start;
+    ++this->counters.acquisitions;
+    ++this->counters.contentions;
+    this->counters.total_wait += wait;
+    if (wait > this->counters.max_wait) this->counters.max_wait = wait;
+    return true;
+#else
+    return pros::c::mutex_recursive_take(this->mutex, timeout);
+#endif
+}
+
+void RecursiveMutex::lock() {
+    // the handle was checked when the mutex was created, so the kernel only gives up on a forever wait if something is
+    // badly wrong, and retrying would just hide it
+    if (!this->take(TIMEOUT_MAX)) fail("could not lock a mutex");
+}
+
+MutexStats RecursiveMutex::stats() {
+    std::lock_guard lock(*this);
+    return this->counters;
+}
+
+void RecursiveMutex::reset_stats() {
+    std::lock_guard lock(*this);
+    this->counters = {};
+}
+} // namespace gamepad::_impl
@@ -0,0 +1,65 @@
+#include "gamepad/rumble.hpp"
+#include "gamepad/todo.hpp"
+#include "pros/misc.h"
+#include "pros/rtos.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <mutex>
+
+namespace gamepad {
+bool Rumble::play(std::string_view pattern, int priority) {
+    if (pattern.empty() || pattern.size() > MAX_PATTERN_LENGTH ||
+        pattern.find_first_not_of(".- ") != std::string_view::npos) {
+        TODO("add error logging")
+        errno = EINVAL;
+        return false;
+    }
+    std::lock_guard lock(this->mutex);
+    auto same = std::find_if(this->queue.begin(), this->queue.end(),
+                             [&](const Pattern& queued) { return pattern == queued.text.data(); });
+    if (same != this->queue.end()) {
+        if (same->priority >= priority) return true;
+        // take the duplicate out, it is put back in below with the higher priority
+        this->queue.erase(same);
+    } else if (this->queue.size() >= MAX_QUEUED) {
+        TODO("add error logging")
+        errno = ENOSPC;
+        return false;
+    }
+    Pattern entry {{}, priority};
+    std::copy(pattern.begin(), pattern.end(), entry.text.begin());
+    auto position = std::find_if(this->queue.begin(), this->queue.end(),
+                                 [&](const Pattern& queued) { return queued.priority < priority; });
+    this->queue.insert(position, entry);
+    return true;
+}
+
+void Rumble::clear() {
+    std::lock_guard lock(this->mutex);
+    this->queue.clear();
+}
+
+bool Rumble::is_idle() {
+    std::lock_guard lock(this->mutex);
+    // compare as signed so this still works when the clock wraps
+    return this->queue.empty() && static_cast<int32_t>(pros::millis() - this->busy_until) >= 0;
+}
+
+bool Rumble::send(uint32_t now) {
+    std::lock_guard lock(this->mutex);
+    if (this->queue.empty() || static_cast<int32_t>(now - this->busy_until) < 0) return false;
+    const Pattern& next = this->queue.front();
+    // a failed send is left in the queue, so it is retried the next time the link is free
+    if (pros::c::controller_rumble(this->id, next.text.data()) != 1) return true;
+    this->busy_until = now + Rumble::duration(next.text.data());
+    this->queue.erase(this->queue.begin());
+    return true;
+}
+
+uint32_t Rumble::duration(std::string_view pattern) {
+    // the controller does not report when a pattern is done, so these are estimates with a little margin
+    uint32_t total = 0;
+    for (char c : pattern) total += c == '-' ? 500 : 200;
+    return total;
+}
+} // namespace gamepad
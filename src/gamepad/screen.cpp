@@ -0,0 +1,83 @@
+#include "gamepad/screen.hpp"
+#include "gamepad/todo.hpp"
+#include "pros/misc.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+
+namespace gamepad {
+bool Screen::set_text(uint8_t line, uint8_t column, std::string_view text) {
+    if (line >= LINES || column >= COLUMNS) {
+        TODO("add error logging")
+        errno = EINVAL;
+        return false;
+    }
+    std::lock_guard lock(this->mutex);
+    const size_t length = std::min<size_t>(text.size(), COLUMNS - column);
+    for (size_t i = 0; i < length; ++i) {
+        // the controller stops at a '\0', so it can't be part of the text
+        this->buffer[line][column + i] = text[i] == '\0' ? ' ' : text[i];
+    }
+    return true;
+}
+
+bool Screen::print(uint8_t line, uint8_t column, const char* fmt, ...) {
+    char text[COLUMNS + 1];
+    va_list args;
+    va_start(args, fmt);
+    const int length = std::vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    if (length < 0) return false;
+    return this->set_text(line, column, {text, std::min<size_t>(length, COLUMNS)});
+}
+
+bool Screen::set_line(uint8_t line, std::string_view text) {
+    std::lock_guard lock(this->mutex);
+    if (!this->clear_line(line)) return false;
+    return this->set_text(line, 0, text);
+}
+
+bool Screen::clear_line(uint8_t line) {
+    if (line >= LINES) {
+        TODO("add error logging")
+        errno = EINVAL;
+        return false;
+    }
+    std::lock_guard lock(this->mutex);
+    this->buffer[line].fill(' ');
+    return true;
+}
+
+void Screen::clear() {
+    std::lock_guard lock(this->mutex);
+    for (auto& line : this->buffer) line.fill(' ');
+    for (auto& line : this->sent) line.fill('\0');
+}
+
+bool Screen::is_synced() {
+    std::lock_guard lock(this->mutex);
+    return this->buffer == this->sent;
+}
+
+bool Screen::send() {
+    std::lock_guard lock(this->mutex);
+    for (uint8_t i = 0; i < LINES; ++i) {
+        const uint8_t line = (this->next_line + i) % LINES;
+        const Line& want = this->buffer[line];
+        Line& have = this->sent[line];
+        const auto first = std::mismatch(want.begin(), want.end(), have.begin()).first - want.begin();
+        if (first == COLUMNS) continue;
+        const auto last = COLUMNS - (std::mismatch(want.rbegin(), want.rend(), have.rbegin()).first - want.rbegin());
+        char text[COLUMNS + 1] {};
+        std::copy(want.begin() + first, want.begin() + last, text);
+        // a failed send is left in the back buffer, so it is retried the next time the link is free
+        if (pros::c::controller_set_text(this->id, line, first, text) != 1) return true;
+        std::copy(want.begin() + first, want.begin() + last, have.begin() + first);
+        this->next_line = (line + 1) % LINES;
+        return true;
+    }
+    return false;
+}
+} // namespace gamepad
@@ -1,4 +1,5 @@
 #include "main.h"
+#include "bench/benchmarks.hpp"
 #include "gamepad/api.hpp"
 #include "gamepad/controller.hpp"
 #include "pros/rtos.hpp"
@@ -52,6 +53,10 @@ void initialize() {
     gamepad::master.A.onRepeatPress("aRepeatPress", aRepeatPress1);
     // And we can use lambda's too
     gamepad::master.X.onShortRelease("xShortRelease1", []() { printf("X Short Release!\n"); });
+#ifdef GAMEPAD_BENCHMARK
+    // add -DGAMEPAD_BENCHMARK to EXTRA_CXXFLAGS to print what the library costs on the brain to the terminal
+    gamepad::bench::run_all();
+#endif
 }
 
 /**